@@ -0,0 +1,523 @@
+#include "../newtpp.hpp"
+#include "pty_harness.hpp"
+#include <array>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Every scenario runs in its own pty. Pass names, or parts of them, to only run those:
+ *   newtpp_bench fast_run
+ */
+
+namespace {
+
+// The body of fast_run() is spelled out, so building the form is timed apart from running it
+void fast_run_demo(const bench::reporter& REPORTER)
+{
+  newt::root_window::init(newt::theme::ONE_LIGHT);
+  newt::root_window::push_default_help_line();
+
+  {
+    std::optional<newt::entrybox> text_input;
+    std::optional<newt::label> label;
+    std::optional<newt::radio_button_collection> rb_collection;
+    std::optional<newt::button> confirm;
+    std::optional<newt::button> del;
+    std::optional<newt::grid> grid;
+    std::optional<newt::window> window;
+    std::optional<newt::form> form;
+    REPORTER.time("construct_ms", [&]() {
+      text_input.emplace(30, newt::position { 0, 0 }, "You can write here!");
+      label.emplace("Hello I am a label");
+      rb_collection.emplace("radio_button0", "radio_button1", "radio_button2", "radio_button3");
+      rb_collection->set_current(0);
+      confirm.emplace("OK");
+      del.emplace("CANCEL");
+
+      grid.emplace(2, 4, *label, *text_input, *rb_collection, *del, *confirm);
+      window.emplace(*grid, "Magic window title");
+      form.emplace(*label, *text_input, *rb_collection, *del, *confirm);
+    });
+
+    form->run();
+  }
+  newt::root_window::finish();
+}
+
+#if defined(NEWTPP_TERMINAL_OUTPUT)
+// The same demo with the output of newt buffered into one write to the terminal per frame
+void buffered_fast_run_demo(const bench::reporter& REPORTER)
+{
+  std::optional<newt::terminal_output> output { std::in_place };
+  fast_run_demo(REPORTER);
+  const auto STATS { output->get_stats() };
+  output.reset();
+
+  REPORTER.report("frames", static_cast<double>(STATS.frames));
+  REPORTER.report("terminal_writes", static_cast<double>(STATS.writes));
+  REPORTER.report("newt_writes", static_cast<double>(STATS.newt_writes));
+  REPORTER.report("bytes_per_frame", static_cast<double>(STATS.bytes) / static_cast<double>(std::max(STATS.frames, 1ULL)));
+}
+#endif
+
+void manual_positioning_demo(const bench::reporter& REPORTER)
+{
+  newt::root_window root;
+
+  std::optional<newt::window> win;
+  std::optional<newt::label> text;
+  std::optional<newt::button> ok_button;
+  std::optional<newt::form> simple_message;
+  REPORTER.time("construct_ms", [&]() {
+    win.emplace(newt::usize { 50, 8 });
+    text.emplace("Hello, could you please press ok?", newt::position { 10, 1 });
+    ok_button.emplace("ok", newt::position { 22, 3 });
+    simple_message.emplace(*text, *ok_button);
+  });
+
+  simple_message->run();
+}
+
+// A listbox over 10M generated rows, only the visible window is ever materialized
+void huge_listbox(const bench::reporter& REPORTER)
+{
+  class numbered_rows : public newt::listbox_source {
+    public:
+    [[nodiscard]] size_t count() const override
+    {
+      return 10'000'000;
+    }
+
+    [[nodiscard]] std::string row(const size_t INDEX) const override
+    {
+      return "row " + std::to_string(INDEX);
+    }
+  };
+
+  newt::root_window root;
+  newt::window win { newt::usize { 40, 20 }, "10M rows" };
+
+  numbered_rows rows;
+  const auto START { bench::clock::now() };
+  newt::listbox list { 18, rows, { 1, 1 } };
+  newt::form form { list };
+  list.bind(form);
+  REPORTER.report("open_ms", std::chrono::duration<double, std::milli>(bench::clock::now() - START).count());
+
+  form.run();
+  REPORTER.report("final_row", static_cast<double>(list.get_current()));
+  REPORTER.report_max_rss();
+}
+
+/*
+ * Every x leaves the form, the caller counts it on the label and goes back in.
+ * The key latency is the round trip through run() or next_event() and the redraw
+ */
+bool counted(const newt::exit_info& EXIT_INFO, newt::label& counter, int& count)
+{
+  if (EXIT_INFO.reason != newt::exit_reason::HOTKEY or std::get<int>(EXIT_INFO.data) != 'x') {
+    return false;
+  }
+
+  counter.set_text(std::to_string(++count));
+  return true;
+}
+
+void dispatch_run(const bench::reporter& REPORTER)
+{
+  newt::root_window root;
+  newt::window win { newt::usize { 20, 3 }, "run()" };
+  newt::label counter { "0", { 1, 1 } };
+  newt::form form { counter };
+  form.add_hot_key('x');
+
+  int count { 0 };
+  while (counted(form.run(), counter, count)) { }
+  REPORTER.report("dispatched", count);
+}
+
+newt::task count_events(newt::form& form, newt::label& counter, int& count, newt::event_loop& loop)
+{
+  while (counted(co_await form.next_event(loop), counter, count)) { }
+  loop.stop();
+}
+
+void dispatch_next_event(const bench::reporter& REPORTER)
+{
+  newt::root_window root;
+  newt::window win { newt::usize { 20, 3 }, "next_event()" };
+  newt::label counter { "0", { 1, 1 } };
+  newt::form form { counter };
+  form.add_hot_key('x');
+
+  int count { 0 };
+  newt::event_loop loop;
+  count_events(form, counter, count, loop);
+  loop.run();
+  REPORTER.report("dispatched", count);
+}
+
+// 200 KiB of help text in paragraphs of about 400 bytes
+std::string help_text()
+{
+  constexpr std::array<std::string_view, 8> WORDS { "the", "form", "reflows", "paragraph", "of", "terminal", "text", "width" };
+
+  std::string text;
+  for (size_t word { 0 }; text.size() < 200 * 1024; ++word) {
+    text += WORDS.at(word * 7 % WORDS.size());
+    text += (word % 64 == 63) ? '\n' : ' ';
+  }
+  return text;
+}
+
+// Resizing wraps all the paragraphs again, changing the text only the paragraphs that changed
+void reflow(const bench::reporter& REPORTER)
+{
+  constexpr int WIDTH { 76 };
+  constexpr int HEIGHT { 18 };
+  constexpr int ROUNDS { 100 };
+
+  newt::root_window root;
+  newt::window win { newt::usize { WIDTH + 2, HEIGHT + 2 }, "help" };
+
+  std::string text { help_text() };
+  std::optional<newt::textbox_reflowed> help;
+  REPORTER.time("construct_ms", [&]() { help.emplace(WIDTH, text, newt::position { 1, 1 }); });
+  help->set_height(HEIGHT);
+
+  const auto START { bench::clock::now() };
+  for (int round { 0 }; round < ROUNDS; ++round) {
+    help->set_width(WIDTH - 1 - round % 2);
+  }
+  REPORTER.report("resize_ms", std::chrono::duration<double, std::milli>(bench::clock::now() - START).count() / ROUNDS);
+
+  const auto EDIT_START { bench::clock::now() };
+  for (int round { 0 }; round < ROUNDS; ++round) {
+    text.back() = static_cast<char>('a' + round % 2);
+    help->set_text(text);
+  }
+  REPORTER.report("edit_last_paragraph_ms", std::chrono::duration<double, std::milli>(bench::clock::now() - EDIT_START).count() / ROUNDS);
+
+  // Every < and > on the terminal resizes the text once
+  newt::form form { *help };
+  int width { WIDTH };
+  form.add_hot_key('<', [&]() { help->set_width(--width); help->set_height(HEIGHT); return true; });
+  form.add_hot_key('>', [&]() { help->set_width(++width); help->set_height(HEIGHT); return true; });
+  form.run();
+}
+
+/*
+ * The component handle before it packed the ownership in a tag bit: the pointer and
+ * a deleter that gets swapped for a no op when the ownership is given away
+ */
+class legacy_handle {
+  using deleter_ptr = void (*)(newtComponent);
+
+  newtComponent data;
+  deleter_ptr deleter;
+
+  static void no_delete(newtComponent /*unused*/) { }
+
+  public:
+  explicit legacy_handle(newtComponent COMPONENT) noexcept
+      : data(COMPONENT)
+      , deleter(newtComponentDestroy)
+  {
+  }
+
+  legacy_handle(const legacy_handle&) = delete;
+  legacy_handle(legacy_handle&& other) noexcept
+      : data(other.data)
+      , deleter(other.deleter)
+  {
+    other.deleter = no_delete;
+  }
+  legacy_handle& operator=(const legacy_handle&) = delete;
+  legacy_handle& operator=(legacy_handle&&) = delete;
+
+  ~legacy_handle()
+  {
+    deleter(data);
+  }
+
+  newtComponent own()
+  {
+    deleter = no_delete;
+    return data;
+  }
+};
+
+constexpr size_t HANDLES { 100'000 };
+
+template <typename handle, typename make>
+void time_handles(const bench::reporter& REPORTER, make&& MAKE)
+{
+  REPORTER.report("handle_bytes", sizeof(handle));
+
+  std::optional<std::vector<handle>> handles { std::in_place };
+  handles->reserve(HANDLES);
+  REPORTER.time("construct_ms", [&]() {
+    for (size_t index { 0 }; index < HANDLES; ++index) {
+      handles->emplace_back(MAKE());
+    }
+  });
+  REPORTER.time("destroy_ms", [&]() { handles.reset(); });
+}
+
+void handles(const bench::reporter& REPORTER)
+{
+  newt::root_window root;
+  newt::window win { newt::usize { 20, 3 }, "handles" };
+
+  time_handles<newt::checkbox>(REPORTER, []() { return newt::checkbox { "x" }; });
+
+  std::vector<newt::checkbox> boxes;
+  boxes.reserve(HANDLES);
+  for (size_t index { 0 }; index < HANDLES; ++index) {
+    boxes.emplace_back("x");
+  }
+
+  std::optional<newt::form> form;
+  REPORTER.time("form_build_ms", [&]() { form.emplace(boxes); });
+  form->run();
+  REPORTER.time("form_destroy_ms", [&]() { form.reset(); });
+  REPORTER.report_max_rss();
+}
+
+void handles_legacy(const bench::reporter& REPORTER)
+{
+  newt::root_window root;
+  newt::window win { newt::usize { 20, 3 }, "legacy handles" };
+
+  const auto MAKE { []() { return legacy_handle { newtCheckbox(0, 0, "x", ' ', nullptr, nullptr) }; } };
+  time_handles<legacy_handle>(REPORTER, MAKE);
+
+  std::vector<legacy_handle> boxes;
+  boxes.reserve(HANDLES);
+  for (size_t index { 0 }; index < HANDLES; ++index) {
+    boxes.emplace_back(MAKE());
+  }
+
+  newtComponent form { nullptr };
+  REPORTER.time("form_build_ms", [&]() {
+    form = newtForm(nullptr, nullptr, 0);
+    for (auto& box : boxes) {
+      newtFormAddComponent(form, box.own());
+    }
+  });
+  newtExitStruct exit {};
+  newtFormRun(form, &exit);
+  REPORTER.time("form_destroy_ms", [&]() { newtFormDestroy(form); });
+  REPORTER.report_max_rss();
+}
+
+/*
+ * Generated configuration forms of 1k, 10k and 100k entries. newt has no call that takes
+ * many components at once, the form adds them one at a time whatever the caller passes
+ */
+void bulk_form(const bench::reporter& REPORTER)
+{
+  newt::root_window root;
+  newt::window win { newt::usize { 40, 3 }, "bulk form" };
+
+  const auto FIELDS { [](const size_t COUNT) {
+    std::vector<newt::entrybox> fields;
+    fields.reserve(COUNT);
+    for (size_t index { 0 }; index < COUNT; ++index) {
+      fields.emplace_back(38, newt::position { 1, 1 });
+    }
+    return fields;
+  } };
+
+  std::optional<newt::form> form;
+  for (const size_t COUNT : { 1'000U, 10'000U, 100'000U }) {
+    const std::string PREFIX { "form_" + std::to_string(COUNT) };
+
+    auto fields { FIELDS(COUNT) };
+    REPORTER.time(PREFIX + "_build_ms", [&]() { form.emplace(fields); });
+    REPORTER.time(PREFIX + "_destroy_ms", [&]() { form.reset(); });
+  }
+
+  auto shown { FIELDS(100'000) };
+  form.emplace(shown);
+  form->run();
+  REPORTER.report_max_rss();
+}
+
+// The same 8x8 layout done by grid and by static_grid, then shown in a window
+void grid_layout(const bench::reporter& REPORTER)
+{
+  constexpr int ROUNDS { 10'000 };
+
+  newt::root_window root;
+
+  std::vector<newt::label> labels;
+  labels.reserve(64);
+  for (int cell { 0 }; cell < 64; ++cell) {
+    labels.emplace_back(std::to_string(cell));
+  }
+  const std::span<const newt::label, 64> CELLS { labels.data(), labels.size() };
+
+  const auto GRID_START { bench::clock::now() };
+  for (int round { 0 }; round < ROUNDS; ++round) {
+    const newt::grid GRID { 8, 8, CELLS };
+  }
+  REPORTER.report("grid_us", std::chrono::duration<double, std::micro>(bench::clock::now() - GRID_START).count() / ROUNDS);
+
+  const auto STATIC_START { bench::clock::now() };
+  for (int round { 0 }; round < ROUNDS; ++round) {
+    const newt::static_grid<8, 8> GRID { CELLS };
+  }
+  REPORTER.report("static_grid_us", std::chrono::duration<double, std::micro>(bench::clock::now() - STATIC_START).count() / ROUNDS);
+
+  const newt::static_grid<8, 8> GRID { CELLS };
+  const newt::window WINDOW { GRID, "8x8" };
+  newt::form form { labels };
+  form.run();
+}
+
+// A 64 MiB log, searched once per needle by find_substring and by std::string_view::find
+void search(const bench::reporter& REPORTER)
+{
+  std::string log;
+  log.reserve(64U << 20U);
+  for (size_t line { 0 }; log.size() < (64U << 20U); ++line) {
+    log += "2026-10-16 12:00:00 worker " + std::to_string(line % 64) + " handled request " + std::to_string(line) + '\n';
+  }
+
+  // The needles are at the end, the whole log is scanned
+  constexpr std::array<std::string_view, 3> NEEDLES { "ab", "disk full", "ERROR: the disk is full, retrying in 5 seconds" };
+  log += "ERROR: the disk is full, retrying in 5 seconds\nab\n";
+
+  const auto THROUGHPUT { [&](const std::string_view NAME, auto&& FIND) {
+    const auto START { bench::clock::now() };
+    const size_t FOUND { FIND() };
+    const std::chrono::duration<double> ELAPSED { bench::clock::now() - START };
+    REPORTER.report(NAME, static_cast<double>(std::min(FOUND, log.size())) / ELAPSED.count() / 1e9);
+  } };
+
+  for (size_t index { 0 }; index < NEEDLES.size(); ++index) {
+    const std::string_view NEEDLE { NEEDLES.at(index) };
+    const std::string SUFFIX { "_" + std::to_string(NEEDLE.size()) + "_bytes_gbps" };
+    THROUGHPUT("find_substring" + SUFFIX, [&]() { return newt::find_substring(log, NEEDLE); });
+    THROUGHPUT("string_view_find" + SUFFIX, [&]() { return std::string_view { log }.find(NEEDLE); });
+  }
+
+  // Typing the query in a viewer of the same log
+  char path[] { "/tmp/newtpp_bench_XXXXXX" };
+  const int FILE_DESCRIPTOR { mkstemp(path) };
+  [[maybe_unused]] const auto WRITTEN { write(FILE_DESCRIPTOR, log.data(), log.size()) };
+  close(FILE_DESCRIPTOR);
+
+  newt::root_window root;
+  newt::window win { newt::usize { 78, 22 }, "search" };
+  newt::entrybox query { 76 };
+  newt::file_viewer viewer { newt::size { 76, 20 }, path, { 0, 2 } };
+  unlink(path);
+
+  newt::incremental_search searching { query, viewer };
+  newt::form form { query, viewer };
+  searching.bind(form);
+  form.run();
+}
+
+std::vector<std::string> concat(std::initializer_list<std::vector<std::string>> PARTS)
+{
+  std::vector<std::string> keys;
+  for (const auto& PART : PARTS) {
+    keys.insert(keys.end(), PART.begin(), PART.end());
+  }
+  return keys;
+}
+
+std::vector<bench::scenario> scenarios()
+{
+  using namespace bench::keys;
+
+  return {
+    {
+        .name = "fast_run_demo",
+        .run = fast_run_demo,
+        // Types in the entry, moves to the radio buttons, picks one and exits
+        .keys = concat({ repeated(RIGHT, 19), typed(" and more"), { TAB, DOWN, DOWN, SPACE, F12 } }),
+    },
+#if defined(NEWTPP_TERMINAL_OUTPUT)
+    {
+        .name = "buffered_fast_run_demo",
+        .run = buffered_fast_run_demo,
+        .keys = concat({ repeated(RIGHT, 19), typed(" and more"), { TAB, DOWN, DOWN, SPACE, F12 } }),
+    },
+#endif
+    {
+        .name = "manual_positioning_demo",
+        .run = manual_positioning_demo,
+        .keys = { TAB, TAB, F12 },
+    },
+    {
+        .name = "huge_listbox",
+        .run = huge_listbox,
+        // Scrolls row by row, by pages, and through the prefetch margin both ways
+        .keys = concat({ repeated(DOWN, 40), repeated(PAGE_DOWN, 40), repeated(UP, 40), repeated(PAGE_UP, 20), { F12 } }),
+    },
+    {
+        .name = "dispatch_run",
+        .run = dispatch_run,
+        .keys = concat({ typed(std::string(200, 'x')), { F12 } }),
+    },
+    {
+        .name = "dispatch_next_event",
+        .run = dispatch_next_event,
+        .keys = concat({ typed(std::string(200, 'x')), { F12 } }),
+    },
+    {
+        .name = "reflow",
+        .run = reflow,
+        .keys = concat({ typed(std::string(20, '<')), typed(std::string(20, '>')), { F12 } }),
+    },
+    {
+        .name = "handles_100k",
+        .run = handles,
+        .keys = { F12 },
+    },
+    {
+        .name = "handles_100k_legacy",
+        .run = handles_legacy,
+        .keys = { F12 },
+    },
+    {
+        .name = "bulk_form",
+        .run = bulk_form,
+        .keys = { F12 },
+    },
+    {
+        .name = "grid_layout",
+        .run = grid_layout,
+        .keys = { F12 },
+    },
+    {
+        .name = "search",
+        .run = search,
+        // Every key searches again, Enter moves to the next match
+        .keys = concat({ typed("request 1999999"), { ENTER, ENTER, F12 } }),
+    },
+  };
+}
+
+}
+
+int main(const int ARGC, const char** ARGV)
+{
+  const std::vector<std::string_view> FILTERS(ARGV + 1, ARGV + ARGC); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  for (const auto& SCENARIO : scenarios()) {
+    const bool SELECTED { FILTERS.empty() or std::ranges::any_of(FILTERS, [&](const std::string_view FILTER) { return SCENARIO.name.find(FILTER) != std::string::npos; }) };
+    if (SELECTED) {
+      bench::print(bench::run(SCENARIO));
+      std::fflush(stdout);
+    }
+  }
+}
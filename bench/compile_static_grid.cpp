@@ -0,0 +1,9 @@
+#include "../newtpp.hpp"
+
+// Lays out every shape up to 8x8 with a static_grid, see compile_grid.cpp
+void layouts(std::span<const newt::component, 64> CELLS)
+{
+  [&]<int... SHAPE>(std::integer_sequence<int, SHAPE...>) {
+    (newt::static_grid<SHAPE % 8 + 1, SHAPE / 8 + 1> { CELLS.template first<static_cast<size_t>((SHAPE % 8 + 1) * (SHAPE / 8 + 1))>() }, ...);
+  }(std::make_integer_sequence<int, 64>());
+}
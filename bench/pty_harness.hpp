@@ -0,0 +1,325 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
+#include <numeric>
+#include <poll.h>
+#include <pty.h>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/*
+ * Runs every scenario in a child process whose terminal is a pty, so newt draws
+ * as it would on a real terminal. The parent writes the scripted keys to the pty,
+ * and times the output newt writes back. A burst of output ends when the pty
+ * stays quiet for a while, and its last byte is when the frame was done
+ */
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+// Used by the child to send measurements to the parent
+class reporter {
+  int file_descriptor;
+
+  public:
+  explicit reporter(const int FILE_DESCRIPTOR) noexcept
+      : file_descriptor(FILE_DESCRIPTOR)
+  {
+  }
+
+  void report(const std::string_view NAME, const double VALUE) const
+  {
+    std::array<char, 256> line {};
+    const int LENGTH { std::snprintf(line.data(), line.size(), "%.*s %.17g\n", static_cast<int>(NAME.size()), NAME.data(), VALUE) };
+    [[maybe_unused]] const auto WRITTEN { write(file_descriptor, line.data(), static_cast<size_t>(std::clamp(LENGTH, 0, static_cast<int>(line.size()) - 1))) };
+  }
+
+  // Reports how long FUNCTION takes, in milliseconds
+  template <typename function>
+  void time(const std::string_view NAME, function&& FUNCTION) const
+  {
+    const auto START { clock::now() };
+    std::forward<function>(FUNCTION)();
+    report(NAME, std::chrono::duration<double, std::milli>(clock::now() - START).count());
+  }
+
+  // Peak resident memory of the child, in KiB
+  void report_max_rss(const std::string_view NAME = "max_rss_kib") const
+  {
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    report(NAME, static_cast<double>(usage.ru_maxrss));
+  }
+};
+
+struct scenario {
+  std::string name;
+  std::function<void(const reporter&)> run; // runs in the child, on the pty
+  std::vector<std::string> keys; // written one at a time, once the previous output settled
+  std::chrono::milliseconds quiet { 30 }; // silence that ends a burst of output
+  std::chrono::milliseconds timeout { 30000 };
+};
+
+struct result {
+  std::string name;
+  double wall_ms { 0 };
+  double first_paint_ms { -1 }; // -1 if nothing was drawn
+  size_t first_paint_bytes { 0 };
+  size_t bytes { 0 };
+  std::vector<double> key_latencies_ms; // only the keys that drew something
+  size_t silent_keys { 0 };
+  std::vector<std::pair<std::string, double>> metrics;
+  int exit_status { -1 };
+  bool timed_out { false };
+};
+
+namespace keys {
+  inline const std::string TAB { "\t" };
+  inline const std::string ENTER { "\r" };
+  inline const std::string SPACE { " " };
+  inline const std::string UP { "\033[A" };
+  inline const std::string DOWN { "\033[B" };
+  inline const std::string RIGHT { "\033[C" };
+  inline const std::string LEFT { "\033[D" };
+  inline const std::string PAGE_UP { "\033[5~" };
+  inline const std::string PAGE_DOWN { "\033[6~" };
+  inline const std::string F12 { "\033[24~" }; // every newt form exits on F12
+
+  inline std::vector<std::string> typed(const std::string_view TEXT)
+  {
+    std::vector<std::string> strokes;
+    for (const char CHAR : TEXT) {
+      strokes.emplace_back(1, CHAR);
+    }
+    return strokes;
+  }
+
+  inline std::vector<std::string> repeated(const std::string& KEY, const size_t TIMES)
+  {
+    return std::vector<std::string>(TIMES, KEY);
+  }
+}
+
+class pty_session {
+  int master { -1 };
+  int reports { -1 };
+  pid_t child { -1 };
+  clock::time_point deadline;
+  std::string report_buffer;
+  result& out;
+
+  // Reads what is available on the report pipe, returns false once the child closed it
+  bool read_reports()
+  {
+    std::array<char, 4096> buffer {};
+    for (;;) {
+      const auto READ { read(reports, buffer.data(), buffer.size()) };
+      if (READ > 0) {
+        report_buffer.append(buffer.data(), static_cast<size_t>(READ));
+      } else if (READ < 0 and errno == EINTR) {
+        continue;
+      } else {
+        return READ != 0;
+      }
+    }
+  }
+
+  /*
+   * Reads the pty until it stays quiet for QUIET, the child exits or the deadline passes.
+   * With WAIT the quiet time starts counting from the first byte. Returns the number of
+   * bytes read and the time of the last one
+   */
+  std::pair<size_t, clock::time_point> settle(const std::chrono::milliseconds QUIET, const bool WAIT = false)
+  {
+    size_t total { 0 };
+    clock::time_point last {};
+
+    while (master != -1) {
+      const auto NOW { clock::now() };
+      if (NOW >= deadline) {
+        out.timed_out = true;
+        break;
+      }
+
+      std::array<pollfd, 2> watched { { { .fd = master, .events = POLLIN, .revents = 0 }, { .fd = reports, .events = POLLIN, .revents = 0 } } };
+      const auto LEFT { (WAIT and total == 0) ? deadline - NOW : std::min<clock::duration>(QUIET, deadline - NOW) };
+      const int READY { poll(watched.data(), (reports == -1) ? 1 : 2, static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(LEFT).count())) };
+      if (READY < 0 and errno == EINTR) {
+        continue;
+      }
+      if (READY <= 0) {
+        break;
+      }
+
+      if (reports != -1 and watched[1].revents != 0 and not read_reports()) {
+        close(reports);
+        reports = -1;
+      }
+
+      if (watched[0].revents == 0) {
+        continue;
+      }
+
+      std::array<char, 1U << 16U> buffer {};
+      const auto READ { read(master, buffer.data(), buffer.size()) };
+      if (READ > 0) {
+        total += static_cast<size_t>(READ);
+        last = clock::now();
+      } else if (READ == 0 or errno != EINTR) {
+        // EIO once the child closed the pty
+        close(master);
+        master = -1;
+      }
+    }
+
+    out.bytes += total;
+    return { total, last };
+  }
+
+  void parse_reports()
+  {
+    size_t start { 0 };
+    for (size_t end { report_buffer.find('\n') }; end != std::string::npos; start = end + 1, end = report_buffer.find('\n', start)) {
+      const std::string_view LINE { std::string_view { report_buffer }.substr(start, end - start) };
+      const auto SPACE { LINE.rfind(' ') };
+      if (SPACE != std::string_view::npos) {
+        out.metrics.emplace_back(std::string { LINE.substr(0, SPACE) }, std::strtod(std::string { LINE.substr(SPACE + 1) }.c_str(), nullptr));
+      }
+    }
+  }
+
+  public:
+  explicit pty_session(result& OUT) noexcept
+      : out(OUT)
+  {
+  }
+
+  pty_session(const pty_session&) = delete;
+  pty_session(pty_session&&) = delete;
+  pty_session& operator=(const pty_session&) = delete;
+  pty_session& operator=(pty_session&&) = delete;
+
+  ~pty_session()
+  {
+    if (master != -1) {
+      close(master);
+    }
+    if (reports != -1) {
+      close(reports);
+    }
+  }
+
+  void run(const scenario& SCENARIO, const winsize SIZE)
+  {
+    std::array<int, 2> pipe_fds { -1, -1 };
+    if (pipe2(pipe_fds.data(), O_CLOEXEC) != 0) {
+      return;
+    }
+
+    winsize window { SIZE };
+    const auto START { clock::now() };
+    child = forkpty(&master, nullptr, nullptr, &window);
+    if (child == -1) {
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      return;
+    }
+
+    if (child == 0) {
+      close(pipe_fds[0]);
+      setenv("TERM", "xterm", 1);
+      int status { 0 };
+      try {
+        SCENARIO.run(reporter { pipe_fds[1] });
+      } catch (...) {
+        status = 1;
+      }
+      std::fflush(stdout);
+      _exit(status);
+    }
+
+    close(pipe_fds[1]);
+    reports = pipe_fds[0];
+    fcntl(reports, F_SETFL, O_NONBLOCK); // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-signed-bitwise)
+    deadline = START + SCENARIO.timeout;
+
+    // The scenario may take a while to set up before drawing anything
+    const auto [PAINTED, PAINT_END] { settle(SCENARIO.quiet, true) };
+    if (PAINTED != 0) {
+      out.first_paint_ms = std::chrono::duration<double, std::milli>(PAINT_END - START).count();
+      out.first_paint_bytes = PAINTED;
+    }
+
+    for (const auto& KEY : SCENARIO.keys) {
+      if (master == -1 or out.timed_out) {
+        break;
+      }
+
+      const auto SENT { clock::now() };
+      [[maybe_unused]] const auto WRITTEN { write(master, KEY.data(), KEY.size()) };
+      const auto [DRAWN, LAST] { settle(SCENARIO.quiet) };
+      if (DRAWN == 0) {
+        ++out.silent_keys;
+      } else {
+        out.key_latencies_ms.push_back(std::chrono::duration<double, std::milli>(LAST - SENT).count());
+      }
+    }
+
+    // Drains the output until the child exits, so it never blocks on a full pty
+    int status { 0 };
+    while (waitpid(child, &status, WNOHANG) == 0) {
+      if (clock::now() >= deadline) {
+        out.timed_out = true;
+        kill(child, SIGKILL);
+        waitpid(child, &status, 0);
+        break;
+      }
+      settle(std::chrono::milliseconds { 5 });
+    }
+    out.wall_ms = std::chrono::duration<double, std::milli>(clock::now() - START).count();
+    out.exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+
+    while (reports != -1 and read_reports()) { }
+    parse_reports();
+  }
+};
+
+inline result run(const scenario& SCENARIO, const winsize SIZE = { .ws_row = 24, .ws_col = 80, .ws_xpixel = 0, .ws_ypixel = 0 })
+{
+  result out {};
+  out.name = SCENARIO.name;
+  pty_session session { out };
+  session.run(SCENARIO, SIZE);
+  return out;
+}
+
+inline void print(const result& RESULT)
+{
+  const auto& LATENCIES { RESULT.key_latencies_ms };
+  const double MEAN { LATENCIES.empty() ? 0 : std::accumulate(LATENCIES.begin(), LATENCIES.end(), 0.0) / static_cast<double>(LATENCIES.size()) };
+  const double WORST { LATENCIES.empty() ? 0 : *std::ranges::max_element(LATENCIES) };
+
+  std::printf("%s%s\n", RESULT.name.c_str(), RESULT.timed_out ? " (timed out)" : (RESULT.exit_status != 0 ? " (failed)" : ""));
+  std::printf("  wall %.2f ms, first paint %.2f ms (%zu bytes), %zu bytes written\n", RESULT.wall_ms, RESULT.first_paint_ms, RESULT.first_paint_bytes, RESULT.bytes);
+  if (not LATENCIES.empty() or RESULT.silent_keys != 0) {
+    std::printf("  keys: %zu drawn, mean %.2f ms, worst %.2f ms, %zu silent\n", LATENCIES.size(), MEAN, WORST, RESULT.silent_keys);
+  }
+  for (const auto& [NAME, VALUE] : RESULT.metrics) {
+    std::printf("  %s %.6g\n", NAME.c_str(), VALUE);
+  }
+}
+
+}
@@ -1,17 +1,261 @@
 #pragma once
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <charconv>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
 #include <concepts>
+#include <coroutine>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <newt.h>
+#include <numeric>
+#include <optional>
+#include <poll.h>
+#include <queue>
+#include <ranges>
+#include <source_location>
 #include <span>
 #include <string>
 #include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+/*
+ * Defining NEWTPP_TERMINAL_OUTPUT before including newtpp adds terminal_output,
+ * it needs the S-Lang headers and S-Lang to be linked
+ */
+#if defined(NEWTPP_TERMINAL_OUTPUT)
+  #if __has_include(<slang.h>)
+    #include <slang.h>
+  #elif __has_include(<slang/slang.h>)
+    #include <slang/slang.h>
+  #else
+    #error "NEWTPP_TERMINAL_OUTPUT needs the S-Lang headers"
+  #endif
+  #include <sys/socket.h>
+#endif
+
+/*
+ * Defining NEWTPP_INSTRUMENT before including newtpp makes every newt call
+ * go through a probe that counts and times it, otherwise calls are direct
+ */
+#if defined(NEWTPP_INSTRUMENT)
+  #define NEWTPP_CALL(FUNCTION) ::newt::instrumentation::probe<&FUNCTION>(#FUNCTION)
+#else
+  #define NEWTPP_CALL(FUNCTION) FUNCTION
+#endif
+
 namespace newt {
 
+/*
+ *    INSTRUMENTATION
+ */
+
+namespace instrumentation {
+#if defined(NEWTPP_INSTRUMENT)
+  inline constexpr bool ENABLED { true };
+#else
+  inline constexpr bool ENABLED { false };
+#endif
+
+  struct call_stats {
+    std::string_view function; // the newt function
+    std::string_view caller;   // the newtpp function that called it
+    std::uint64_t calls { 0 };
+    std::chrono::nanoseconds total { 0 };
+    std::chrono::nanoseconds longest { 0 };
+
+    // Class of the caller, "label" for "void newt::label::set_text(...)", empty for free functions
+    [[nodiscard]] std::string_view get_component() const
+    {
+      auto name { caller.substr(0, caller.find('(')) };
+      name.remove_prefix(std::min(name.size(), name.rfind(' ') + 1));
+
+      const auto METHOD { name.rfind("::") };
+      if (METHOD == std::string_view::npos) {
+        return {};
+      }
+      name = name.substr(0, METHOD);
+
+      const auto SCOPE { name.rfind("::") };
+      return (SCOPE == std::string_view::npos) ? std::string_view {} : name.substr(SCOPE + 2);
+    }
+  };
+
+  /*
+   * Keyed by the addresses of the names, call sites are merged by name when reading the stats.
+   * newt isn't thread safe so all the calls come from one thread and the stats aren't synchronized
+   */
+  using call_site = std::pair<const char*, const char*>;
+
+  struct call_site_hash {
+    size_t operator()(const call_site& SITE) const
+    {
+      return std::hash<const void*> {}(SITE.first) ^ (std::hash<const void*> {}(SITE.second) * 31);
+    }
+  };
+
+  inline std::unordered_map<call_site, call_stats, call_site_hash>& registry()
+  {
+    static std::unordered_map<call_site, call_stats, call_site_hash> stats;
+    return stats;
+  }
+
+  template <auto FUNCTION>
+  class probe {
+    const char* name;
+    std::source_location location;
+
+    class timer {
+      call_stats& stats;
+      std::chrono::steady_clock::time_point start { std::chrono::steady_clock::now() };
+
+      public:
+      explicit timer(call_stats& STATS)
+          : stats(STATS)
+      {
+      }
+
+      timer(const timer&) = delete;
+      timer(timer&&) = delete;
+      timer& operator=(const timer&) = delete;
+      timer& operator=(timer&&) = delete;
+
+      ~timer()
+      {
+        const auto ELAPSED { std::chrono::steady_clock::now() - start };
+        ++stats.calls;
+        stats.total += ELAPSED;
+        stats.longest = std::max<std::chrono::nanoseconds>(stats.longest, ELAPSED);
+      }
+    };
+
+    public:
+    explicit probe(const char* NAME, const std::source_location LOCATION = std::source_location::current())
+        : name(NAME)
+        , location(LOCATION)
+    {
+    }
+
+    template <typename... args>
+    decltype(auto) operator()(args&&... ARGS) const
+    {
+      auto& stats { registry().try_emplace({ name, location.function_name() }, call_stats { .function = name, .caller = location.function_name() }).first->second };
+      const timer TIMER { stats };
+      return FUNCTION(std::forward<args>(ARGS)...);
+    }
+  };
+
+  // Sorted by total time, newtFormRun and the other blocking calls include the time spent waiting for the user
+  [[nodiscard]] inline std::vector<call_stats> snapshot()
+  {
+    std::vector<call_stats> merged;
+    for (const auto& [SITE, STATS] : registry()) {
+      const auto SAME { std::find_if(merged.begin(), merged.end(), [&](const call_stats& OTHER) { return OTHER.function == STATS.function and OTHER.caller == STATS.caller; }) };
+      if (SAME == merged.end()) {
+        merged.push_back(STATS);
+      } else {
+        SAME->calls += STATS.calls;
+        SAME->total += STATS.total;
+        SAME->longest = std::max(SAME->longest, STATS.longest);
+      }
+    }
+
+    std::sort(merged.begin(), merged.end(), [](const call_stats& LEFT, const call_stats& RIGHT) { return LEFT.total > RIGHT.total; });
+    return merged;
+  }
+
+  [[nodiscard]] inline std::string to_json()
+  {
+    const auto QUOTE { [](std::string& json, const std::string_view TEXT) {
+      json += '"';
+      for (const char CHARACTER : TEXT) {
+        if (CHARACTER == '"' or CHARACTER == '\\') {
+          json += '\\';
+        }
+        json += CHARACTER;
+      }
+      json += '"';
+    } };
+
+    std::string json { "[" };
+    for (const auto& STATS : snapshot()) {
+      json += (json.size() == 1) ? "\n  {" : ",\n  {";
+      json += "\"function\": ";
+      QUOTE(json, STATS.function);
+      json += ", \"caller\": ";
+      QUOTE(json, STATS.caller);
+      json += ", \"component\": ";
+      QUOTE(json, STATS.get_component());
+      json += ", \"calls\": " + std::to_string(STATS.calls);
+      json += ", \"total_ns\": " + std::to_string(STATS.total.count());
+      json += ", \"max_ns\": " + std::to_string(STATS.longest.count());
+      json += '}';
+    }
+    json += (json.size() == 1) ? "]" : "\n]";
+
+    return json;
+  }
+
+  // Shows the TOP newt functions by total time, summed over all the callers
+  inline void show_in_help_line(const size_t TOP = 3)
+  {
+    std::vector<call_stats> functions;
+    for (const auto& STATS : snapshot()) {
+      const auto SAME { std::find_if(functions.begin(), functions.end(), [&](const call_stats& OTHER) { return OTHER.function == STATS.function; }) };
+      if (SAME == functions.end()) {
+        functions.push_back(STATS);
+      } else {
+        SAME->calls += STATS.calls;
+        SAME->total += STATS.total;
+      }
+    }
+    std::sort(functions.begin(), functions.end(), [](const call_stats& LEFT, const call_stats& RIGHT) { return LEFT.total > RIGHT.total; });
+
+    std::string line;
+    for (size_t index { 0 }; index < std::min(TOP, functions.size()); ++index) {
+      const auto MICROSECONDS { std::chrono::duration_cast<std::chrono::microseconds>(functions[index].total).count() };
+      line += (line.empty() ? "" : " | ");
+      line += std::string { functions[index].function } + " " + std::to_string(functions[index].calls) + "x " + std::to_string(MICROSECONDS) + "us";
+    }
+
+    newtPopHelpLine();
+    newtPushHelpLine(line.empty() ? nullptr : line.c_str());
+  }
+
+  inline void reset()
+  {
+    registry().clear();
+  }
+}
+
 /*
  *    CONCEPTS AND UTILITYS
  */
@@ -22,37 +266,55 @@ concept generic_component = requires {
   requires std::derived_from<T, component> or std::same_as<T, component>;
 };
 
-template <typename type>
+enum class ownership : bool {
+  BORROWED,
+  OWNED
+};
+
+/*
+ * The ownership flag is stored in the lowest bit of the pointer, which is
+ * always zero for heap allocated objects, and the deleter is part of the type,
+ * so the whole handle is as big as a raw pointer
+ */
+template <typename type, void (*deleter)(type*)>
 class conditional_ownership_ptr {
   public:
   using value_type = type;
   using value_type_ptr = type*;
-  using deleter_ptr = void (*)(value_type_ptr);
 
   private:
-  value_type_ptr data { nullptr };
-  deleter_ptr deleter { no_delete };
+  static constexpr std::uintptr_t OWNED_TAG { 1 };
+  std::uintptr_t bits { 0 };
+
+  static std::uintptr_t tag(value_type_ptr pointer, const ownership OWNERSHIP) noexcept
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return reinterpret_cast<std::uintptr_t>(pointer) | ((OWNERSHIP == ownership::OWNED) ? OWNED_TAG : 0);
+  }
+
+  void release() noexcept
+  {
+    if (is_owner()) {
+      deleter(get());
+    }
+  }
 
   public:
-  static void no_delete(value_type_ptr /*unused*/) { }
-  conditional_ownership_ptr(value_type_ptr pointer, deleter_ptr deleter_fun)
-      : data { pointer }
-      , deleter(deleter_fun)
+  conditional_ownership_ptr(value_type_ptr pointer, const ownership OWNERSHIP) noexcept
+      : bits { tag(pointer, OWNERSHIP) }
   {
   }
 
   conditional_ownership_ptr(conditional_ownership_ptr& other) noexcept
-      : data(other.data)
-      , deleter(other.deleter)
+      : bits(other.bits)
   {
-    other.deleter = no_delete;
+    other.bits &= ~OWNED_TAG;
   }
 
   conditional_ownership_ptr(conditional_ownership_ptr&& other) noexcept
-      : data(other.data)
-      , deleter(other.deleter)
+      : bits(other.bits)
   {
-    other.deleter = no_delete;
+    other.bits &= ~OWNED_TAG;
   }
 
   /*
@@ -63,41 +325,133 @@ class conditional_ownership_ptr {
 
   conditional_ownership_ptr& operator=(conditional_ownership_ptr&& other) noexcept
   {
-    deleter(data);
+    release();
 
-    data = other.data;
-    deleter = other.deleter;
-    other.deleter = conditional_ownership_ptr::no_delete;
+    bits = other.bits;
+    other.bits &= ~OWNED_TAG;
 
     return *this;
   }
 
-  bool operator<=>(const conditional_ownership_ptr&) const = default;
-
-  value_type_ptr operator*()
+  // An owning and a borrowing handle to the same object compare equal
+  bool operator==(const conditional_ownership_ptr& OTHER) const
   {
-    return data;
+    return get() == OTHER.get();
   }
 
   value_type_ptr operator*() const
   {
-    return data;
+    return get();
   }
 
   [[nodiscard]] value_type_ptr get() const
   {
-    return data;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+    return reinterpret_cast<value_type_ptr>(bits & ~OWNED_TAG);
+  }
+
+  [[nodiscard]] bool is_owner() const
+  {
+    return (bits & OWNED_TAG) != 0;
   }
 
   [[nodiscard]] value_type_ptr own()
   {
-    deleter = no_delete;
-    return data;
+    bits &= ~OWNED_TAG;
+    return get();
   }
 
   ~conditional_ownership_ptr() noexcept
   {
-    deleter(data);
+    release();
+  }
+};
+
+/*
+ *    NULL TERMINATED STRINGS
+ */
+
+class staging_arena {
+  /*
+   * Bump allocator for the strings that have to be null terminated before
+   * reaching newt. newt copies every string it receives, so the staged copies
+   * are only needed until the end of the frame, reset() recycles the chunks.
+   * Only refresh() and running a form reset it: the staged strings live until
+   * then, and a loop staging strings without either keeps growing the arena
+   */
+  static constexpr size_t CHUNK_SIZE { 4096 };
+
+  std::vector<std::vector<char>> chunks;
+  size_t current { 0 };
+  size_t used { 0 };
+
+  public:
+  const char* stage(const std::string_view TEXT)
+  {
+    const size_t NEEDED { TEXT.size() + 1 };
+
+    while (current < chunks.size() and chunks[current].size() - used < NEEDED) {
+      ++current;
+      used = 0;
+    }
+    if (current == chunks.size()) {
+      chunks.emplace_back(std::max(CHUNK_SIZE, NEEDED));
+      used = 0;
+    }
+
+    char* const STAGED { chunks[current].data() + used };
+    std::copy(TEXT.begin(), TEXT.end(), STAGED);
+    STAGED[TEXT.size()] = '\0'; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    used += NEEDED;
+
+    return STAGED;
+  }
+
+  void reset()
+  {
+    current = 0;
+    used = 0;
+  }
+
+  static staging_arena& local()
+  {
+    thread_local staging_arena arena;
+    return arena;
+  }
+};
+
+/*
+ * Parameter type of the functions that hand a string to newt.
+ * Pointers and std::string are already null terminated and pass through for free,
+ * std::string_view gets copied in the staging arena of the thread
+ */
+class c_string_view {
+  const char* pointer { nullptr };
+
+  public:
+  c_string_view() = default;
+
+  // NOLINTNEXTLINE(hicpp-explicit-conversions, google-explicit-constructor)
+  c_string_view(const char* TEXT) noexcept
+      : pointer(TEXT)
+  {
+  }
+
+  // NOLINTNEXTLINE(hicpp-explicit-conversions, google-explicit-constructor)
+  c_string_view(const std::string& TEXT) noexcept
+      : pointer(TEXT.c_str())
+  {
+  }
+
+  // NOLINTNEXTLINE(hicpp-explicit-conversions, google-explicit-constructor)
+  c_string_view(const std::string_view TEXT)
+      : pointer((TEXT.data() == nullptr) ? nullptr : staging_arena::local().stage(TEXT))
+  {
+  }
+
+  [[nodiscard]] const char* c_str() const noexcept
+  {
+    return pointer;
   }
 };
 
@@ -289,7 +643,7 @@ namespace theme {
 
   static void set(const colors& THEME)
   {
-    newtSetColors(static_cast<newtColors>(THEME));
+    NEWTPP_CALL(newtSetColors)(static_cast<newtColors>(THEME));
   }
 
   constexpr static colors ONE_DARK {
@@ -346,143 +700,649 @@ namespace theme {
 };
 
 /*
- *    ROOT WINDOW AND OTHER FREE FUNCTIONS
+ *    TEXT REFLOW
  */
 
-class root_window {
-  public:
-  static void init(const theme::colors& THEME = theme::ONE_DARK) noexcept
+class reflow_cache {
+  /*
+   * Line breaks are cached per paragraph, a paragraph is wrapped again only
+   * if its text or the width changed since the last time it was wrapped
+   */
+  struct paragraph {
+    std::string text;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> lines; // begin, end
+    int wrapped_width { -1 };
+  };
+
+  std::vector<paragraph> paragraphs;
+  std::string output;
+  int width;
+  bool stale { true };
+
+  static bool is_ascii(const std::string_view TEXT)
   {
-    newtInit();
-    newtCls();
-    theme::set(THEME);
+    size_t index { 0 };
+#if defined(__SSE2__)
+    constexpr size_t LANES { sizeof(__m128i) };
+    __m128i high_bits { _mm_setzero_si128() };
+    for (; index + LANES <= TEXT.size(); index += LANES) {
+      high_bits = _mm_or_si128(high_bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(TEXT.data() + index))); // NOLINT
+    }
+    if (_mm_movemask_epi8(high_bits) != 0) {
+      return false;
+    }
+#endif
+    return std::all_of(TEXT.begin() + static_cast<std::ptrdiff_t>(index), TEXT.end(), [](const char CHARACTER) { return (static_cast<unsigned char>(CHARACTER) & 0x80U) == 0; });
   }
 
-  static void finish() noexcept
+  // Last space in [BEGIN, END), or END if there is none
+  static size_t last_space(const std::string_view TEXT, const size_t BEGIN, size_t end)
   {
-    newtFinished();
+    const size_t NOT_FOUND { end };
+#if defined(__SSE2__)
+    constexpr size_t LANES { sizeof(__m128i) };
+    const __m128i SPACES { _mm_set1_epi8(' ') };
+    while (end - BEGIN >= LANES) {
+      end -= LANES;
+      const __m128i CHUNK { _mm_loadu_si128(reinterpret_cast<const __m128i*>(TEXT.data() + end)) }; // NOLINT
+      const auto MASK { static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(CHUNK, SPACES))) };
+      if (MASK != 0) {
+        return end + static_cast<size_t>(31 - __builtin_clz(MASK));
+      }
+    }
+#endif
+    while (end > BEGIN) {
+      if (TEXT[--end] == ' ') {
+        return end;
+      }
+    }
+    return NOT_FOUND;
   }
 
-  explicit root_window(const theme::colors& THEME = theme::ONE_DARK)
+  static void wrap_ascii(paragraph& PARAGRAPH, const size_t WIDTH)
   {
-    init(THEME);
-  }
+    const std::string_view TEXT { PARAGRAPH.text };
+    size_t begin { 0 };
 
-  root_window(root_window&) = delete;
-  root_window(root_window&&) = default;
-  root_window& operator=(root_window&) = delete;
-  root_window& operator=(root_window&&) = delete;
+    while (TEXT.size() - begin > WIDTH) {
+      // A space right after the last column is a valid break too
+      const size_t SPACE { last_space(TEXT, begin, begin + WIDTH + 1) };
+      size_t end { (SPACE == begin + WIDTH + 1 or SPACE == begin) ? begin + WIDTH : SPACE };
+      size_t next { end };
 
-  ~root_window()
+      while (end > begin and TEXT[end - 1] == ' ') {
+        --end;
+      }
+      while (next < TEXT.size() and TEXT[next] == ' ') {
+        ++next;
+      }
+
+      PARAGRAPH.lines.emplace_back(begin, end);
+      begin = next;
+    }
+
+    if (begin < TEXT.size() or PARAGRAPH.lines.empty()) {
+      PARAGRAPH.lines.emplace_back(begin, TEXT.size());
+    }
+  }
+
+  // Same as wrap_ascii but counting utf-8 code points as columns
+  static void wrap_utf8(paragraph& PARAGRAPH, const size_t WIDTH)
   {
-    finish();
+    const std::string_view TEXT { PARAGRAPH.text };
+    const auto IS_CONTINUATION { [&](const size_t INDEX) { return (static_cast<unsigned char>(TEXT[INDEX]) & 0xC0U) == 0x80U; } };
+
+    size_t begin { 0 };
+    while (begin < TEXT.size()) {
+      size_t index { begin };
+      size_t columns { 0 };
+      size_t space { TEXT.size() };
+
+      while (index < TEXT.size() and columns < WIDTH) {
+        if (TEXT[index] == ' ') {
+          space = index;
+        }
+        ++index;
+        while (index < TEXT.size() and IS_CONTINUATION(index)) {
+          ++index;
+        }
+        ++columns;
+      }
+
+      if (index == TEXT.size()) {
+        break;
+      }
+
+      size_t end { (TEXT[index] == ' ') ? index : ((space != TEXT.size() and space != begin) ? space : index) };
+      size_t next { end };
+      while (end > begin and TEXT[end - 1] == ' ') {
+        --end;
+      }
+      while (next < TEXT.size() and TEXT[next] == ' ') {
+        ++next;
+      }
+
+      PARAGRAPH.lines.emplace_back(begin, end);
+      begin = next;
+    }
+
+    if (begin < TEXT.size() or PARAGRAPH.lines.empty()) {
+      PARAGRAPH.lines.emplace_back(begin, TEXT.size());
+    }
   }
 
-  static void draw_text(const position POS, const std::string_view TEXT)
+  void wrap(paragraph& PARAGRAPH) const
   {
-    newtDrawRootText(POS.left, POS.top, TEXT.data());
+    const auto WIDTH { static_cast<size_t>(std::max(width, 1)) };
+
+    PARAGRAPH.lines.clear();
+    if (is_ascii(PARAGRAPH.text)) {
+      wrap_ascii(PARAGRAPH, WIDTH);
+    } else {
+      wrap_utf8(PARAGRAPH, WIDTH);
+    }
+    PARAGRAPH.wrapped_width = width;
   }
 
-  static void push_help_line(const std::string_view TEXT)
+  public:
+  explicit reflow_cache(const int WIDTH) noexcept
+      : width(WIDTH)
   {
-    newtPushHelpLine(TEXT.data());
   }
 
-  static void push_default_help_line()
+  void set_text(const std::string_view TEXT)
   {
-    // newt automatically pushes the default help line if the given pointer is nullptr
-    newtPushHelpLine(nullptr);
+    size_t count { 0 };
+    size_t begin { 0 };
+
+    do {
+      const size_t END { std::min(TEXT.find('\n', begin), TEXT.size()) };
+      const std::string_view LINE { TEXT.substr(begin, END - begin) };
+
+      if (count == paragraphs.size()) {
+        paragraphs.emplace_back();
+      }
+
+      auto& cached { paragraphs[count++] };
+      if (cached.text != LINE) {
+        cached.text = LINE;
+        cached.wrapped_width = -1;
+      }
+
+      begin = END + 1;
+    } while (begin <= TEXT.size());
+
+    paragraphs.resize(count);
+    stale = true;
   }
 
-  static void clear_help_line()
+  void set_width(const int WIDTH)
   {
-    // newt automatically clears the default help line if the given pointer is pointing to an empty string
-    push_help_line("");
+    stale = stale or WIDTH != width;
+    width = WIDTH;
   }
 
-  static void pop_help_line()
+  [[nodiscard]] int get_width() const
   {
-    newtPopHelpLine();
+    return width;
   }
 
-  /* TODO: Add suspand api  <29-03-23, Giuseppe> */
-};
+  // Wraps the paragraphs that changed and returns the whole reflowed text
+  const std::string& get_text()
+  {
+    if (not stale) {
+      return output;
+    }
 
-inline void refresh()
-{
-  newtRefresh();
-}
+    size_t total { 0 };
+    for (auto& cached : paragraphs) {
+      if (cached.wrapped_width != width) {
+        wrap(cached);
+      }
+      total += cached.text.size() + cached.lines.size();
+    }
 
-inline void bell()
-{
-  newtBell();
-}
+    output.clear();
+    output.reserve(total);
+    for (const auto& CACHED : paragraphs) {
+      for (const auto& [BEGIN, END] : CACHED.lines) {
+        output.append(CACHED.text, BEGIN, END - BEGIN);
+        output += '\n';
+      }
+    }
+    if (not output.empty()) {
+      output.pop_back();
+    }
 
-inline size get_screen_size()
-{
-  size screen_size;
-  newtGetScreenSize(&screen_size.width, &screen_size.height);
+    stale = false;
+    return output;
+  }
 
-  return screen_size;
-}
+  [[nodiscard]] size_t get_num_lines()
+  {
+    get_text();
 
-inline usize get_screen_usize()
-{
-  return usize { get_screen_size() };
-}
+    size_t lines { 0 };
+    for (const auto& CACHED : paragraphs) {
+      lines += CACHED.lines.size();
+    }
+    return lines;
+  }
+};
 
-inline void clear_key_buffer()
-{
-  newtClearKeyBuffer();
-}
+/*
+ *    TEXT SEARCH
+ */
 
-inline void wait_for_key()
+/*
+ * Offset of the first NEEDLE in HAYSTACK at or after FROM, npos if there is none.
+ * 16 candidate positions at a time are filtered comparing both the first and the
+ * last byte of NEEDLE, only the positions matching both get compared in full
+ */
+[[nodiscard]] inline size_t find_substring(const std::string_view HAYSTACK, const std::string_view NEEDLE, const size_t FROM = 0)
 {
-  newtWaitForKey();
-}
+  if (FROM > HAYSTACK.size() or HAYSTACK.size() - FROM < NEEDLE.size()) {
+    return std::string_view::npos;
+  }
 
-inline void reflow_text(std::string& text, const int WIDTH)
-{
-  const int MAX_FLEX { static_cast<int>(WIDTH / 5) };
-  newtReflowText(text.data(), WIDTH, MAX_FLEX, MAX_FLEX, nullptr, nullptr);
+  if (NEEDLE.size() <= 1) {
+    return HAYSTACK.find(NEEDLE, FROM);
+  }
+
+  size_t index { FROM };
+#if defined(__SSE2__)
+  constexpr size_t LANES { sizeof(__m128i) };
+  const size_t CANDIDATES { HAYSTACK.size() - NEEDLE.size() + 1 };
+  const __m128i FIRST { _mm_set1_epi8(NEEDLE.front()) };
+  const __m128i LAST { _mm_set1_epi8(NEEDLE.back()) };
+
+  for (; index + LANES <= CANDIDATES; index += LANES) {
+    const __m128i BLOCK_FIRST { _mm_loadu_si128(reinterpret_cast<const __m128i*>(HAYSTACK.data() + index)) }; // NOLINT
+    const __m128i BLOCK_LAST { _mm_loadu_si128(reinterpret_cast<const __m128i*>(HAYSTACK.data() + index + NEEDLE.size() - 1)) }; // NOLINT
+    auto mask { static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(BLOCK_FIRST, FIRST), _mm_cmpeq_epi8(BLOCK_LAST, LAST)))) };
+
+    while (mask != 0) {
+      const auto CANDIDATE { index + static_cast<size_t>(__builtin_ctz(mask)) };
+      if (std::memcmp(HAYSTACK.data() + CANDIDATE + 1, NEEDLE.data() + 1, NEEDLE.size() - 2) == 0) {
+        return CANDIDATE;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+  return HAYSTACK.find(NEEDLE, index);
 }
 
-[[nodiscard]] inline std::string compute_filler(const std::string_view OLD, const std::string_view NEW)
-{
-  size_t filling_size { OLD.size() - NEW.size() };
+/*
+ *         TERMINAL OUTPUT
+ */
 
-  /*
-   * if filling_size is > OLD.size() it means that NEW.size() is bigger
-   * and doing the subtraction we caused the filling_size to overflow so
-   * instead we use 0
-   */
+#if defined(NEWTPP_TERMINAL_OUTPUT)
 
-  filling_size = (filling_size < OLD.size()) ? filling_size : 0;
+/*
+ * newt writes a frame in many chunks, as big as the S-Lang output buffer. While a
+ * terminal_output is alive S-Lang writes to a socket instead of the terminal, and a
+ * thread forwards what newt writes with a single write for each frame. A frame ends at
+ * refresh(), or once newt stops writing for IDLE, for the frames newt draws by itself
+ * while running a form. The socket keeps the boundaries of the writes, so they're counted.
+ * Only the writes to the terminal come down to one per frame, newt still writes to the socket
+ */
+class terminal_output {
+  public:
+  struct stats {
+    unsigned long long bytes;
+    unsigned long long writes; // write() calls to the terminal
+    unsigned long long newt_writes; // write() calls of newt to the socket, made on its thread
+    unsigned long long frames;
+    unsigned long long last_frame; // bytes
+    unsigned long long largest_frame; // bytes
+  };
 
-  std::string filler;
-  std::fill_n(filler.begin(), filling_size, ' ');
+  private:
+  static inline std::atomic<terminal_output*> active { nullptr };
 
-  return filler;
-}
+  int terminal { -1 };
+  int buffer_read { -1 };
+  int buffer_write { -1 };
+  int wake_fd { -1 };
+  std::chrono::milliseconds idle;
+
+  std::atomic<unsigned long long> bytes { 0 };
+  std::atomic<unsigned long long> writes { 0 };
+  std::atomic<unsigned long long> newt_writes { 0 };
+  std::atomic<unsigned long long> frames { 0 };
+  std::atomic<unsigned long long> last_frame { 0 };
+  std::atomic<unsigned long long> largest_frame { 0 };
+
+  std::jthread flusher;
+
+  // Appends a message for each write of newt, returns false once the socket is closed
+  bool drain(std::string& frame)
+  {
+    for (;;) {
+      const auto SIZE { recv(buffer_read, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT) }; // NOLINT(hicpp-signed-bitwise)
+      if (SIZE < 0 and errno == EINTR) {
+        continue;
+      }
+      if (SIZE <= 0) {
+        return SIZE != 0;
+      }
+
+      const auto OLD_SIZE { frame.size() };
+      frame.resize(OLD_SIZE + static_cast<size_t>(SIZE));
+      const auto READ { recv(buffer_read, frame.data() + OLD_SIZE, static_cast<size_t>(SIZE), MSG_DONTWAIT) };
+      frame.resize(OLD_SIZE + static_cast<size_t>(std::max(READ, ssize_t { 0 })));
+      newt_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void write_frame(std::string& frame)
+  {
+    if (frame.empty()) {
+      return;
+    }
+
+    std::string_view left { frame };
+    while (not left.empty()) {
+      const auto WRITTEN { write(terminal, left.data(), left.size()) };
+      writes.fetch_add(1, std::memory_order_relaxed);
+      if (WRITTEN < 0 and errno == EINTR) {
+        continue;
+      }
+      if (WRITTEN <= 0) {
+        break;
+      }
+      left.remove_prefix(static_cast<size_t>(WRITTEN));
+    }
+
+    const auto SIZE { static_cast<unsigned long long>(frame.size()) };
+    bytes.fetch_add(SIZE, std::memory_order_relaxed);
+    frames.fetch_add(1, std::memory_order_relaxed);
+    last_frame.store(SIZE, std::memory_order_relaxed);
+    if (SIZE > largest_frame.load(std::memory_order_relaxed)) {
+      largest_frame.store(SIZE, std::memory_order_relaxed);
+    }
+    frame.clear();
+  }
+
+  void forward(const std::stop_token& STOP)
+  {
+    std::string frame;
+    bool open { true };
+
+    while (open) {
+      std::array<pollfd, 2> watched { { { .fd = buffer_read, .events = POLLIN, .revents = 0 }, { .fd = wake_fd, .events = POLLIN, .revents = 0 } } };
+      const int TIMEOUT { frame.empty() ? -1 : static_cast<int>(idle.count()) };
+      const int READY { poll(watched.data(), watched.size(), TIMEOUT) };
+      if (READY < 0 and errno == EINTR) {
+        continue;
+      }
+
+      // The socket is drained before the end of the frame is handled, the bytes written before refresh() returned are there
+      open = drain(frame);
+
+      if (READY == 0 or (watched[1].revents & POLLIN) != 0) { // NOLINT(hicpp-signed-bitwise)
+        std::uint64_t counter { 0 };
+        [[maybe_unused]] const auto READ { read(wake_fd, &counter, sizeof(counter)) };
+        write_frame(frame);
+      }
+
+      if (STOP.stop_requested()) {
+        drain(frame);
+        write_frame(frame);
+        return;
+      }
+    }
+
+    write_frame(frame);
+  }
+
+  void wake() const
+  {
+    const std::uint64_t ONE { 1 };
+    [[maybe_unused]] const auto WRITTEN { write(wake_fd, &ONE, sizeof(ONE)) };
+  }
+
+  public:
+  /*
+   * Only the output of newt goes through the socket, stdout is left alone.
+   * Best created before root_window::init, and destroyed after root_window::finish to forward its output
+   */
+  explicit terminal_output(const std::chrono::milliseconds IDLE = std::chrono::milliseconds { 1 }) noexcept
+      : idle(std::max(IDLE, std::chrono::milliseconds { 1 }))
+  {
+    terminal_output* expected { nullptr };
+    if (not active.compare_exchange_strong(expected, this)) {
+      return;
+    }
+
+    std::array<int, 2> socket_fds { -1, -1 };
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); // NOLINT(hicpp-signed-bitwise)
+    if (wake_fd == -1 or socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, socket_fds.data()) != 0) { // NOLINT(hicpp-signed-bitwise)
+      close(wake_fd);
+      wake_fd = -1;
+      active.store(nullptr);
+      return;
+    }
+
+    // A whole frame fits in the socket, so newt doesn't wait for the terminal in the middle of one
+    const int BUFFER_SIZE { 1 << 20 };
+    setsockopt(socket_fds[1], SOL_SOCKET, SO_SNDBUF, &BUFFER_SIZE, sizeof(BUFFER_SIZE));
+    buffer_read = socket_fds[0];
+    buffer_write = socket_fds[1];
+
+    // S-Lang picks stdout when it's initialized, if nobody chose a descriptor before
+    terminal = (SLang_TT_Write_FD == -1) ? STDOUT_FILENO : SLang_TT_Write_FD;
+    SLang_TT_Write_FD = buffer_write;
+
+    flusher = std::jthread { [this](const std::stop_token& STOP) { forward(STOP); } };
+  }
+
+  terminal_output(const terminal_output&) = delete;
+  terminal_output(terminal_output&&) = delete;
+  terminal_output& operator=(const terminal_output&) = delete;
+  terminal_output& operator=(terminal_output&&) = delete;
+
+  // Forwards what is left and gives the terminal back to S-Lang
+  ~terminal_output()
+  {
+    if (not is_installed()) {
+      return;
+    }
+
+    active.store(nullptr);
+    SLang_TT_Write_FD = terminal;
+    flusher.request_stop();
+    wake();
+    flusher.join();
+
+    close(buffer_write);
+    close(buffer_read);
+    close(wake_fd);
+  }
+
+  // Sends the frame written so far without waiting for newt to be idle, called by refresh()
+  static void end_frame()
+  {
+    if (const auto* const OUTPUT { active.load(std::memory_order_acquire) }; OUTPUT != nullptr and OUTPUT->wake_fd != -1) {
+      OUTPUT->wake();
+    }
+  }
+
+  // False if the socket couldn't be created, or another terminal_output is alive
+  [[nodiscard]] bool is_installed() const
+  {
+    return buffer_read != -1;
+  }
+
+  [[nodiscard]] stats get_stats() const
+  {
+    return {
+      .bytes = bytes.load(std::memory_order_relaxed),
+      .writes = writes.load(std::memory_order_relaxed),
+      .newt_writes = newt_writes.load(std::memory_order_relaxed),
+      .frames = frames.load(std::memory_order_relaxed),
+      .last_frame = last_frame.load(std::memory_order_relaxed),
+      .largest_frame = largest_frame.load(std::memory_order_relaxed),
+    };
+  }
+
+  void reset_stats()
+  {
+    bytes.store(0, std::memory_order_relaxed);
+    writes.store(0, std::memory_order_relaxed);
+    newt_writes.store(0, std::memory_order_relaxed);
+    frames.store(0, std::memory_order_relaxed);
+    last_frame.store(0, std::memory_order_relaxed);
+    largest_frame.store(0, std::memory_order_relaxed);
+  }
+};
+
+#endif
+
+/*
+ *    ROOT WINDOW AND OTHER FREE FUNCTIONS
+ */
+
+class root_window {
+  public:
+  static void init(const theme::colors& THEME = theme::ONE_DARK) noexcept
+  {
+    NEWTPP_CALL(newtInit)();
+    NEWTPP_CALL(newtCls)();
+    theme::set(THEME);
+  }
+
+  static void finish() noexcept
+  {
+    NEWTPP_CALL(newtFinished)();
+  }
+
+  explicit root_window(const theme::colors& THEME = theme::ONE_DARK)
+  {
+    init(THEME);
+  }
+
+  root_window(root_window&) = delete;
+  root_window(root_window&&) = default;
+  root_window& operator=(root_window&) = delete;
+  root_window& operator=(root_window&&) = delete;
+
+  ~root_window()
+  {
+    finish();
+  }
+
+  static void draw_text(const position POS, const c_string_view TEXT)
+  {
+    NEWTPP_CALL(newtDrawRootText)(POS.left, POS.top, TEXT.c_str());
+  }
+
+  static void push_help_line(const c_string_view TEXT)
+  {
+    NEWTPP_CALL(newtPushHelpLine)(TEXT.c_str());
+  }
+
+  static void push_default_help_line()
+  {
+    // newt automatically pushes the default help line if the given pointer is nullptr
+    NEWTPP_CALL(newtPushHelpLine)(nullptr);
+  }
+
+  static void clear_help_line()
+  {
+    // newt automatically clears the default help line if the given pointer is pointing to an empty string
+    push_help_line("");
+  }
+
+  static void pop_help_line()
+  {
+    NEWTPP_CALL(newtPopHelpLine)();
+  }
+
+  /* TODO: Add suspand api  <29-03-23, Giuseppe> */
+};
+
+inline void refresh()
+{
+  NEWTPP_CALL(newtRefresh)();
+#if defined(NEWTPP_TERMINAL_OUTPUT)
+  terminal_output::end_frame();
+#endif
+  staging_arena::local().reset();
+}
+
+inline void bell()
+{
+  NEWTPP_CALL(newtBell)();
+}
+
+inline size get_screen_size()
+{
+  size screen_size;
+  NEWTPP_CALL(newtGetScreenSize)(&screen_size.width, &screen_size.height);
+
+  return screen_size;
+}
+
+inline usize get_screen_usize()
+{
+  return usize { get_screen_size() };
+}
+
+inline void clear_key_buffer()
+{
+  NEWTPP_CALL(newtClearKeyBuffer)();
+}
+
+inline void wait_for_key()
+{
+  NEWTPP_CALL(newtWaitForKey)();
+}
+
+inline void reflow_text(std::string& text, const int WIDTH)
+{
+  reflow_cache reflowed { WIDTH };
+  reflowed.set_text(text);
+  text = reflowed.get_text();
+}
+
+[[nodiscard]] inline std::string compute_filler(const std::string_view OLD, const std::string_view NEW)
+{
+  size_t filling_size { OLD.size() - NEW.size() };
+
+  /*
+   * if filling_size is > OLD.size() it means that NEW.size() is bigger
+   * and doing the subtraction we caused the filling_size to overflow so
+   * instead we use 0
+   */
+
+  filling_size = (filling_size < OLD.size()) ? filling_size : 0;
+
+  std::string filler;
+  std::fill_n(filler.begin(), filling_size, ' ');
+
+  return filler;
+}
 
 void inline resize_screen(const int REDRAW)
 {
-  newtResizeScreen(REDRAW);
+  NEWTPP_CALL(newtResizeScreen)(REDRAW);
 }
 
 void inline delay(const unsigned int USECS)
 {
-  newtDelay(USECS);
+  NEWTPP_CALL(newtDelay)(USECS);
 }
 
 void inline cursor_on()
 {
-  newtCursorOn();
+  NEWTPP_CALL(newtCursorOn)();
 }
 
 void inline cursor_off()
 {
-  newtCursorOff();
+  NEWTPP_CALL(newtCursorOff)();
 }
 
 /*
@@ -490,20 +1350,25 @@ void inline cursor_off()
  */
 
 class component {
+  // newtComponentDestroy dispatches to the destroy op of the kind, newtFormDestroy for forms
+  static void destroy(newtComponent COMPONENT)
+  {
+    NEWTPP_CALL(newtComponentDestroy)(COMPONENT);
+  }
 
   public:
-  using ptr_type = conditional_ownership_ptr<std::remove_pointer<newtComponent>::type>;
+  using ptr_type = conditional_ownership_ptr<std::remove_pointer<newtComponent>::type, destroy>;
 
   protected:
   public:
   ptr_type data;
-  explicit component(newtComponent COMP, auto deleter) noexcept
-      : data(COMP, deleter)
+  explicit component(newtComponent COMP, const ownership OWNERSHIP) noexcept
+      : data(COMP, OWNERSHIP)
   {
   }
 
   explicit component(newtComponent COMP) noexcept
-      : data(COMP, newtComponentDestroy)
+      : data(COMP, ownership::OWNED)
   {
   }
 
@@ -542,12 +1407,30 @@ class component {
   /* TODO: Add general component manipulation <29-03-23, Giuseppe> */
 };
 
+// Components are stored by value in spans and vectors, keep them pointer sized
+static_assert(sizeof(component) == sizeof(newtComponent));
+
+// Vectors, arrays and spans of components can be passed wherever a collection can
+template <typename T>
+concept contiguous_components = std::ranges::contiguous_range<T> and generic_component<std::ranges::range_value_t<T>>;
+
 template <typename T>
-concept component_range = requires(T obj) {
+concept component_range = contiguous_components<T> or requires(T obj) {
   {
     obj.as_range()
   } -> std::same_as<std::span<component>>;
 };
+
+template <typename range>
+  requires component_range<std::remove_const_t<range>>
+[[nodiscard]] auto components_of(range& COMPONENTS)
+{
+  if constexpr (contiguous_components<std::remove_const_t<range>>) {
+    return std::span { COMPONENTS };
+  } else {
+    return COMPONENTS.as_range();
+  }
+}
 /*
  *       GRIDS
  */
@@ -590,7 +1473,7 @@ class grid {
 
   public:
   explicit grid(const int COLS, const int ROWS) noexcept
-      : data(newtCreateGrid(COLS, ROWS))
+      : data(NEWTPP_CALL(newtCreateGrid)(COLS, ROWS))
       , cols(COLS)
       , rows(ROWS)
   {
@@ -598,7 +1481,7 @@ class grid {
 
   template <component_range... ranges>
   explicit grid(const int COLS, const int ROWS, const ranges&... COMPONENTS) noexcept
-      : data(newtCreateGrid(COLS, ROWS))
+      : data(NEWTPP_CALL(newtCreateGrid)(COLS, ROWS))
       , cols(COLS)
       , rows(ROWS)
   {
@@ -612,21 +1495,21 @@ class grid {
 
   ~grid()
   {
-    newtGridFree(data, 1);
+    NEWTPP_CALL(newtGridFree)(data, 1);
   }
 
   template <generic_component component_t>
   void set_field(const int COL, const int ROW, const component_t& COMPONENT, const padding PADDING = {}, const int ANCHOR = anchor::NOWHERE, const int GROW = grow::NO)
   {
-    newtGridSetField(data, COL, ROW, NEWT_GRID_COMPONENT, *COMPONENT, PADDING.left, PADDING.top, PADDING.right, PADDING.bottom, ANCHOR, GROW);
+    NEWTPP_CALL(newtGridSetField)(data, COL, ROW, NEWT_GRID_COMPONENT, *COMPONENT, PADDING.left, PADDING.top, PADDING.right, PADDING.bottom, ANCHOR, GROW);
   }
 
   template <component_range... ranges>
   void set_fields(const ranges&... COMPONENTS)
   {
     auto set { [&]<component_range range>(const range& COMP) {
-      for (const auto& COMPONENT : COMP.as_range()) {
-        newtGridSetField(data, auto_cols, auto_rows, NEWT_GRID_COMPONENT, *COMPONENT, 0, 0, 0, (auto_rows != (rows - 1)) ? 1 : 0, 0, 0);
+      for (const auto& COMPONENT : components_of(COMP)) {
+        NEWTPP_CALL(newtGridSetField)(data, auto_cols, auto_rows, NEWT_GRID_COMPONENT, *COMPONENT, 0, 0, 0, (auto_rows != (rows - 1)) ? 1 : 0, 0, 0);
         increment_auto();
       }
     } };
@@ -645,34 +1528,110 @@ class grid {
   }
 };
 
+// Single components, and arrays or fixed extent spans of them, whose size is known at compile time
+template <typename T>
+concept statically_sized_components = generic_component<T> or (contiguous_components<T> and (std::is_bounded_array_v<T> or requires { std::tuple_size<T>::value; } or (requires { T::extent; } and T::extent != std::dynamic_extent)));
+
+template <statically_sized_components T>
+[[nodiscard]] constexpr std::size_t static_size_of()
+{
+  if constexpr (generic_component<T>) {
+    return 1;
+  } else if constexpr (std::is_bounded_array_v<T>) {
+    return std::extent_v<T>;
+  } else if constexpr (requires { std::tuple_size<T>::value; }) {
+    return std::tuple_size_v<T>;
+  } else {
+    return T::extent;
+  }
+}
+
+/*
+ * grid with the shape known at compile time. Only statically sized arguments are accepted,
+ * so the number of components is checked at compile time and the cell of every component
+ * comes from a constexpr table, without the auto placement of set_fields()
+ */
+template <int COLS, int ROWS>
+class static_grid : public grid {
+  static_assert(COLS > 0 and ROWS > 0, "A grid needs at least one cell");
+
+  struct cell {
+    int col;
+    int row;
+    int bottom_padding;
+  };
+
+  static constexpr std::size_t CELLS { static_cast<std::size_t>(COLS) * ROWS };
+
+  static constexpr std::array<cell, CELLS> PLACEMENT { [] {
+    std::array<cell, CELLS> placement {};
+    for (std::size_t index { 0 }; index < CELLS; ++index) {
+      const int ROW { static_cast<int>(index) / COLS };
+      placement[index] = { static_cast<int>(index) % COLS, ROW, (ROW != (ROWS - 1)) ? 1 : 0 };
+    }
+    return placement;
+  }() };
+
+  // Cell of the first component of every argument
+  template <typename... ranges>
+  static constexpr std::array<std::size_t, sizeof...(ranges)> FIRST_CELLS { [] {
+    std::array<std::size_t, sizeof...(ranges)> firsts {};
+    std::size_t next { 0 };
+    std::size_t index { 0 };
+    ((firsts[index++] = next, next += static_size_of<ranges>()), ...);
+    return firsts;
+  }() };
+
+  template <std::size_t FIRST, typename range>
+  void place(const range& COMP)
+  {
+    const auto PARTS { components_of(COMP) };
+    [&]<std::size_t... INDEX>(std::index_sequence<INDEX...>) {
+      (set_field(PLACEMENT[FIRST + INDEX].col, PLACEMENT[FIRST + INDEX].row, PARTS[INDEX], padding { .bottom = PLACEMENT[FIRST + INDEX].bottom_padding }), ...);
+    }(std::make_index_sequence<static_size_of<range>()>());
+  }
+
+  public:
+  template <statically_sized_components... ranges>
+  explicit static_grid(const ranges&... COMPONENTS) noexcept
+      : grid(COLS, ROWS)
+  {
+    static_assert((static_size_of<ranges>() + ... + 0) <= CELLS, "Too many components for the grid");
+
+    [&]<std::size_t... ARGUMENT>(std::index_sequence<ARGUMENT...>) {
+      (place<FIRST_CELLS<ranges...>[ARGUMENT]>(COMPONENTS), ...);
+    }(std::index_sequence_for<ranges...>());
+  }
+};
+
 /*
  *         WINDOW
  */
 
 class window {
   public:
-  explicit window(const usize SIZE, const std::string_view TITLE = std::string_view {}) noexcept
+  explicit window(const usize SIZE, const c_string_view TITLE = {}) noexcept
   {
-    newtCenteredWindow(SIZE.width, SIZE.height, TITLE.data());
+    NEWTPP_CALL(newtCenteredWindow)(SIZE.width, SIZE.height, TITLE.c_str());
   }
 
-  window(const position POS, const usize SIZE, const std::string_view TITLE = std::string_view {}) noexcept
+  window(const position POS, const usize SIZE, const c_string_view TITLE = {}) noexcept
   {
-    newtOpenWindow(POS.left, POS.top, SIZE.width, SIZE.height, TITLE.data());
+    NEWTPP_CALL(newtOpenWindow)(POS.left, POS.top, SIZE.width, SIZE.height, TITLE.c_str());
   }
 
-  [[nodiscard]] explicit window(const grid& GRID, const std::string_view TITLE = {}) noexcept
+  [[nodiscard]] explicit window(const grid& GRID, const c_string_view TITLE = {}) noexcept
   {
     /* I hate that i had to use const cast but newt is not consistent with
        its API, why does newtGridWrappedWindow takes a char* and other methods
        to construct windows instead are taking const char*
        NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast) */
-    newtGridWrappedWindow(static_cast<newtGrid>(GRID), const_cast<char*>(TITLE.data()));
+    NEWTPP_CALL(newtGridWrappedWindow)(static_cast<newtGrid>(GRID), const_cast<char*>(TITLE.c_str()));
   }
 
   ~window()
   {
-    newtPopWindow();
+    NEWTPP_CALL(newtPopWindow)();
   }
 
   window(window&) noexcept = delete;
@@ -690,18 +1649,18 @@ class scroll_bar : public component {
   public:
   /* TODO: Change colors things <02-04-23, Giuseppe> */
   scroll_bar(const position POS, const int HEIGHT, const int NORMAL_COLOR_SET, const int THUMB_COLOR_SET) noexcept
-      : component(newtVerticalScrollbar(POS.left, POS.top, HEIGHT, NORMAL_COLOR_SET, THUMB_COLOR_SET))
+      : component(NEWTPP_CALL(newtVerticalScrollbar)(POS.left, POS.top, HEIGHT, NORMAL_COLOR_SET, THUMB_COLOR_SET))
   {
   }
 
   void set(const int WHERE, const int TOTAL)
   {
-    newtScrollbarSet(*data, WHERE, TOTAL);
+    NEWTPP_CALL(newtScrollbarSet)(*data, WHERE, TOTAL);
   }
 
   void set_color(const int NORMAL, const int THUMB)
   {
-    newtScrollbarSetColors(*data, NORMAL, THUMB);
+    NEWTPP_CALL(newtScrollbarSetColors)(*data, NORMAL, THUMB);
   }
 };
 
@@ -725,12 +1684,12 @@ struct exit_info {
       data = OTHER.u.key;
       break;
     case exit_reason::COMPONENT:
-      data = component { OTHER.u.co, component::ptr_type::no_delete };
+      data = component { OTHER.u.co, ownership::BORROWED };
       break;
     case exit_reason::TIMER:
+    case exit_reason::FDREADY:
       data = OTHER.u.watch;
       break;
-    case exit_reason::FDREADY:
     case exit_reason::ERROR:
     default:
       data = -1;
@@ -739,318 +1698,4026 @@ struct exit_info {
   }
 };
 
-class form : public component {
+/*
+ *         TIMERS
+ */
+
+class timer_wheel {
   public:
-  explicit form(void* help_tag = nullptr, const int FLAGS = 0) noexcept
-      : component(newtForm(nullptr, help_tag, FLAGS), newtFormDestroy)
-  {
-  }
+  using clock = std::chrono::steady_clock;
 
-  /* TODO:  what the fuck is helptag? <02-04-23, Giuseppe> */
-  explicit form(scroll_bar& bar, void* help_tag = nullptr, const int FLAGS = 0) noexcept
-      : component(newtForm(bar.own(), help_tag, FLAGS), newtFormDestroy)
-  {
-    /* TODO: Implement parameters support <29-03-23, Giuseppe> */
-  }
+  struct timer_id {
+    std::uint32_t index { 0 };
+    std::uint32_t generation { 0 };
+  };
 
-  template <component_range... ranges>
-  explicit form(ranges&... components) noexcept
-      : component(newtForm(nullptr, nullptr, 0), newtFormDestroy)
-  {
-    add_components(components...);
-  }
+  private:
+  static constexpr std::uint32_t NONE { ~std::uint32_t { 0 } };
+  static constexpr size_t SLOTS { 256 };
+
+  enum class state : std::uint8_t {
+    FREE,
+    ARMED,
+    FIRING,
+    CANCELLED
+  };
 
-  template <component_range... ranges>
-  void add_components(ranges&... components)
-  {
-    auto add { [&]<component_range range>(range& comp) {
-      for (auto& comp : comp.as_range()) {
-        newtFormAddComponent(*data, comp.own());
-      }
-    } };
+  /*
+   * Hashed wheel: every slot is an intrusive doubly linked list of entries,
+   * timers further than a full turn wait for the remaining rounds
+   */
+  struct entry {
+    std::function<void()> callback;
+    std::chrono::milliseconds interval { 0 };
+    unsigned long long period { 0 }; // interval in ticks
+    unsigned long long rounds { 0 };
+    std::uint32_t previous { NONE };
+    std::uint32_t next { NONE };
+    std::uint32_t slot { 0 };
+    std::uint32_t generation { 1 };
+    state status { state::FREE };
+    bool repeat { false };
+  };
 
-    (add(components), ...);
-  }
+  std::vector<entry> entries;
+  std::vector<std::uint32_t> free_entries;
+  std::array<std::uint32_t, SLOTS> slots {};
+  std::vector<std::uint32_t> expired;
+  unsigned long long current { 0 };
+  size_t armed { 0 };
+  std::chrono::milliseconds resolution;
+  clock::time_point last_tick;
 
-  exit_info run()
+  [[nodiscard]] unsigned long long ticks_of(const std::chrono::milliseconds DURATION) const
   {
-    newtExitStruct result {};
-    newtFormRun(*data, &result);
-
-    return exit_info { result };
+    return std::max<unsigned long long>(static_cast<unsigned long long>((DURATION + resolution - std::chrono::milliseconds { 1 }) / resolution), 1);
   }
 
-  void add_hot_key(const int KEY)
+  void link(const std::uint32_t INDEX)
   {
-    newtFormAddHotKey(*data, KEY);
+    link(INDEX, entries[INDEX].period);
   }
 
-  void watch_fd(const int FILE_DESCRIPTOR, const int FLAGS)
+  void link(const std::uint32_t INDEX, const unsigned long long TICKS)
   {
-    newtFormWatchFd(*data, FILE_DESCRIPTOR, FLAGS);
+    auto& timer { entries[INDEX] };
+    const size_t SLOT { (current + TICKS) % SLOTS };
+
+    timer.rounds = (TICKS - 1) / SLOTS;
+    timer.slot = static_cast<std::uint32_t>(SLOT);
+    timer.previous = NONE;
+    timer.next = slots.at(SLOT);
+    if (timer.next != NONE) {
+      entries[timer.next].previous = INDEX;
+    }
+    slots.at(SLOT) = INDEX;
+    timer.status = state::ARMED;
   }
 
-  void draw_form()
+  void unlink(const std::uint32_t INDEX)
   {
-    newtDrawForm(*data);
+    const auto& timer { entries[INDEX] };
+    if (timer.previous != NONE) {
+      entries[timer.previous].next = timer.next;
+    } else {
+      slots.at(timer.slot) = timer.next;
+    }
+    if (timer.next != NONE) {
+      entries[timer.next].previous = timer.previous;
+    }
   }
 
-  template <generic_component component_t>
-  void set_current(const component_t& comp)
+  void release(const std::uint32_t INDEX)
   {
-    newtFormSetCurrent(*data, *comp);
+    auto& timer { entries[INDEX] };
+    timer.callback = nullptr;
+    timer.status = state::FREE;
+    ++timer.generation;
+    free_entries.push_back(INDEX);
+    --armed;
   }
 
-  void set_background(const int COLOR)
+  void tick()
   {
-    newtFormSetBackground(*data, COLOR);
-  }
+    ++current;
+    const size_t SLOT { current % SLOTS };
+
+    expired.clear();
+    for (std::uint32_t index { slots.at(SLOT) }; index != NONE;) {
+      auto& timer { entries[index] };
+      const std::uint32_t NEXT { timer.next };
+
+      if (timer.rounds == 0) {
+        unlink(index);
+        timer.status = state::FIRING;
+        expired.push_back(index);
+      } else {
+        --timer.rounds;
+      }
+      index = NEXT;
+    }
 
-  void set_height(const int HEIGHT)
-  {
-    newtFormSetHeight(*data, HEIGHT);
+    /*
+     * Callbacks can add and cancel timers, even the ones expired in this same tick.
+     * Adding can move the entries, so the callback is moved out while it runs and back after
+     */
+    for (size_t position { 0 }; position < expired.size(); ++position) {
+      const std::uint32_t INDEX { expired[position] };
+      if (entries[INDEX].status == state::FIRING) {
+        auto callback { std::move(entries[INDEX].callback) };
+        callback();
+        entries[INDEX].callback = std::move(callback);
+      }
+
+      if (entries[INDEX].status == state::FIRING and entries[INDEX].repeat) {
+        link(INDEX);
+      } else {
+        release(INDEX);
+      }
+    }
   }
 
-  void set_width(const int WIDTH)
+  public:
+  explicit timer_wheel(const std::chrono::milliseconds RESOLUTION = std::chrono::milliseconds { 10 }) noexcept
+      : resolution(std::max(RESOLUTION, std::chrono::milliseconds { 1 }))
+      , last_tick(clock::now())
   {
-    newtFormSetWidth(*data, WIDTH);
+    slots.fill(NONE);
+  }
+
+  timer_id add(const std::chrono::milliseconds PERIOD, std::function<void()> CALLBACK, const bool REPEAT = true)
+  {
+    if (armed == 0) {
+      last_tick = clock::now();
+    }
+
+    std::uint32_t index { 0 };
+    if (free_entries.empty()) {
+      index = static_cast<std::uint32_t>(entries.size());
+      entries.emplace_back();
+    } else {
+      index = free_entries.back();
+      free_entries.pop_back();
+    }
+
+    auto& timer { entries[index] };
+    timer.callback = std::move(CALLBACK);
+    timer.interval = PERIOD;
+    timer.period = ticks_of(PERIOD);
+    timer.repeat = REPEAT;
+    link(index);
+    ++armed;
+
+    return timer_id { .index = index, .generation = timer.generation };
+  }
+
+  void cancel(const timer_id ID)
+  {
+    if (ID.index >= entries.size() or entries[ID.index].generation != ID.generation) {
+      return;
+    }
+
+    auto& timer { entries[ID.index] };
+    if (timer.status == state::ARMED) {
+      unlink(ID.index);
+      release(ID.index);
+    } else if (timer.status == state::FIRING) {
+      // Released by tick() once the callbacks of this tick are done
+      timer.status = state::CANCELLED;
+    }
+  }
+
+  // Fires the timers expired since the last call, returns the number of ticks elapsed
+  unsigned long long advance()
+  {
+    const auto NOW { clock::now() };
+    const auto TICKS { static_cast<unsigned long long>((NOW - last_tick) / resolution) };
+    last_tick += TICKS * resolution;
+
+    advance(TICKS);
+    return TICKS;
+  }
+
+  void advance(const unsigned long long TICKS)
+  {
+    for (unsigned long long count { 0 }; count < TICKS and armed != 0; ++count) {
+      tick();
+    }
+  }
+
+  [[nodiscard]] bool empty() const
+  {
+    return armed == 0;
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return armed;
+  }
+
+  [[nodiscard]] std::chrono::milliseconds get_resolution() const
+  {
+    return resolution;
+  }
+
+  /*
+   * The armed timers are moved to the new ticks and keep their ids, what was left of
+   * their period is rounded up to the new resolution. The current tick restarts now
+   */
+  void set_resolution(const std::chrono::milliseconds RESOLUTION)
+  {
+    const auto OLD_RESOLUTION { resolution };
+    resolution = std::max(RESOLUTION, std::chrono::milliseconds { 1 });
+    last_tick = clock::now();
+
+    std::vector<std::pair<std::uint32_t, std::chrono::milliseconds>> remaining;
+    for (std::uint32_t index { 0 }; index < entries.size(); ++index) {
+      auto& timer { entries[index] };
+      if (timer.status == state::FREE) {
+        continue;
+      }
+
+      // The timers firing in this tick are linked again by tick() with the new period
+      timer.period = ticks_of(timer.interval);
+      if (timer.status == state::ARMED) {
+        const unsigned long long OFFSET { (timer.slot + SLOTS - current % SLOTS) % SLOTS };
+        const unsigned long long TICKS_LEFT { timer.rounds * SLOTS + ((OFFSET == 0) ? SLOTS : OFFSET) };
+        remaining.emplace_back(index, TICKS_LEFT * OLD_RESOLUTION);
+      }
+    }
+
+    slots.fill(NONE);
+    for (const auto& [INDEX, LEFT] : remaining) {
+      link(INDEX, ticks_of(LEFT));
+    }
+  }
+};
+
+/*
+ *         ASYNC EVENT LOOP
+ */
+
+// Eagerly started coroutine that destroys itself when it ends
+struct task {
+  struct promise_type {
+    task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept { }
+    [[noreturn]] void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+class event_loop {
+  public:
+  using clock = std::chrono::steady_clock;
+
+  private:
+  struct timer {
+    clock::time_point when;
+    unsigned long long sequence;
+    std::function<void()> callback;
+
+    bool operator>(const timer& OTHER) const
+    {
+      return std::tie(when, sequence) > std::tie(OTHER.when, OTHER.sequence);
+    }
+  };
+
+  int epoll_fd;
+  std::unordered_map<int, std::function<void()>> readers;
+  std::priority_queue<timer, std::vector<timer>, std::greater<>> timers;
+  unsigned long long timers_sequence { 0 };
+  bool stopped { false };
+
+  void fire_timers()
+  {
+    const auto NOW { clock::now() };
+    while (not timers.empty() and timers.top().when <= NOW) {
+      // top() is const, the callback is copied out before popping
+      const auto CALLBACK { timers.top().callback };
+      timers.pop();
+      CALLBACK();
+    }
+  }
+
+  [[nodiscard]] int timeout_ms() const
+  {
+    if (timers.empty()) {
+      return -1;
+    }
+
+    const auto LEFT { timers.top().when - clock::now() };
+    return (LEFT <= clock::duration::zero()) ? 0 : static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(LEFT).count());
+  }
+
+  public:
+  event_loop()
+      : epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+  {
+    if (epoll_fd == -1) {
+      throw std::system_error(errno, std::generic_category(), "epoll_create1");
+    }
+  }
+
+  event_loop(const event_loop&) = delete;
+  event_loop(event_loop&&) = delete;
+  event_loop& operator=(const event_loop&) = delete;
+  event_loop& operator=(event_loop&&) = delete;
+
+  ~event_loop()
+  {
+    close(epoll_fd);
+  }
+
+  // CALLBACK is called once, the next time FILE_DESCRIPTOR is readable. Only one callback per descriptor
+  void when_readable(const int FILE_DESCRIPTOR, std::function<void()> CALLBACK)
+  {
+    readers[FILE_DESCRIPTOR] = std::move(CALLBACK);
+
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    epoll_event event { .events = EPOLLIN | EPOLLONESHOT, .data = { .fd = FILE_DESCRIPTOR } };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, FILE_DESCRIPTOR, &event) != 0) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_ADD, FILE_DESCRIPTOR, &event);
+    }
+  }
+
+  void cancel(const int FILE_DESCRIPTOR)
+  {
+    if (readers.erase(FILE_DESCRIPTOR) != 0) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, FILE_DESCRIPTOR, nullptr);
+    }
+  }
+
+  void when_elapsed(const clock::duration DELAY, std::function<void()> CALLBACK)
+  {
+    timers.push(timer { .when = clock::now() + DELAY, .sequence = timers_sequence++, .callback = std::move(CALLBACK) });
+  }
+
+  [[nodiscard]] auto readable(const int FILE_DESCRIPTOR)
+  {
+    struct awaiter {
+      event_loop& loop;
+      int file_descriptor;
+
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> HANDLE) { loop.when_readable(file_descriptor, [HANDLE]() { HANDLE.resume(); }); }
+      void await_resume() const noexcept { }
+    };
+
+    return awaiter { *this, FILE_DESCRIPTOR };
+  }
+
+  [[nodiscard]] auto sleep_for(const clock::duration DELAY)
+  {
+    struct awaiter {
+      event_loop& loop;
+      clock::duration delay;
+
+      bool await_ready() const noexcept { return delay <= clock::duration::zero(); }
+      void await_suspend(std::coroutine_handle<> HANDLE) { loop.when_elapsed(delay, [HANDLE]() { HANDLE.resume(); }); }
+      void await_resume() const noexcept { }
+    };
+
+    return awaiter { *this, DELAY };
+  }
+
+  // Dispatches events until stop() is called or there is nothing left to wait for
+  void run()
+  {
+    constexpr int MAX_EVENTS { 64 };
+    std::array<epoll_event, MAX_EVENTS> events {};
+
+    stopped = false;
+    while (not stopped and (not readers.empty() or not timers.empty())) {
+      const int READY { epoll_wait(epoll_fd, events.data(), MAX_EVENTS, timeout_ms()) };
+
+      for (int index { 0 }; index < READY; ++index) {
+        const auto READER { readers.find(events.at(static_cast<size_t>(index)).data.fd) };
+        if (READER == readers.end()) {
+          continue;
+        }
+
+        const auto CALLBACK { std::move(READER->second) };
+        readers.erase(READER);
+        CALLBACK();
+      }
+
+      fire_timers();
+    }
+  }
+
+  void stop()
+  {
+    stopped = true;
+  }
+};
+
+/*
+ *         RECORD AND REPLAY
+ */
+
+/*
+ * The exits of the forms recorded into it, or replayed from it. Components are stored as
+ * their position in the form and timers as the ticks the timer wheel advanced, so a
+ * replay takes the same decisions of the recorded run. The keys newt handles inside
+ * the components, like the text typed in an entry, never reach newtpp and aren't recorded
+ */
+class session_log {
+  public:
+  using clock = std::chrono::steady_clock;
+
+  struct event {
+    std::chrono::microseconds time; // since the start of the recording
+    exit_reason reason;
+    int value; // key, component position, fd or timer ticks
+    bool expired; // the timer set with set_timer() expired
+  };
+
+  private:
+  static constexpr std::string_view MAGIC { "NEWTPPS1" };
+
+  std::vector<event> events;
+  size_t position { 0 };
+  clock::time_point origin;
+  bool started { false };
+
+  // Time spent by the application between getting an event and asking for the next one
+  clock::time_point delivered;
+  std::chrono::nanoseconds busy { 0 };
+  std::chrono::nanoseconds longest { 0 };
+
+  static void put_varint(std::string& out, unsigned long long VALUE)
+  {
+    for (; VALUE >= 0x80U; VALUE >>= 7U) {
+      out += static_cast<char>((VALUE & 0x7FU) | 0x80U);
+    }
+    out += static_cast<char>(VALUE);
+  }
+
+  static std::optional<unsigned long long> get_varint(std::string_view& in)
+  {
+    unsigned long long value { 0 };
+    for (unsigned shift { 0 }; not in.empty() and shift < 64; shift += 7) {
+      const auto BYTE { static_cast<unsigned char>(in.front()) };
+      in.remove_prefix(1);
+      value |= static_cast<unsigned long long>(BYTE & 0x7FU) << shift;
+      if ((BYTE & 0x80U) == 0) {
+        return value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  public:
+  // Time since the first recorded or replayed event
+  [[nodiscard]] std::chrono::microseconds elapsed()
+  {
+    if (not started) {
+      origin = clock::now();
+      started = true;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - origin);
+  }
+
+  void record(const event& EVENT)
+  {
+    events.push_back(EVENT);
+  }
+
+  // Returns the next event, waiting for its time if REALTIME, or nullptr when all were replayed
+  const event* next(const bool REALTIME)
+  {
+    const auto NOW { clock::now() };
+    if (position != 0) {
+      const auto BUSY { NOW - delivered };
+      busy += BUSY;
+      longest = std::max<std::chrono::nanoseconds>(longest, BUSY);
+    }
+
+    if (position == events.size()) {
+      return nullptr;
+    }
+
+    if (not started) {
+      origin = NOW - events[position].time;
+      started = true;
+    }
+
+    const auto& EVENT { events[position++] };
+    if (REALTIME) {
+      std::this_thread::sleep_until(time_of(EVENT));
+    }
+
+    delivered = clock::now();
+    return &EVENT;
+  }
+
+  // The time EVENT happened in the current replay, or recording
+  [[nodiscard]] clock::time_point time_of(const event& EVENT) const
+  {
+    return origin + EVENT.time;
+  }
+
+  // Starts replaying from the first event, clearing the stats
+  void rewind()
+  {
+    position = 0;
+    started = false;
+    busy = std::chrono::nanoseconds { 0 };
+    longest = std::chrono::nanoseconds { 0 };
+  }
+
+  void clear()
+  {
+    events.clear();
+    rewind();
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return events.size();
+  }
+
+  [[nodiscard]] bool is_done() const
+  {
+    return position == events.size();
+  }
+
+  [[nodiscard]] std::span<const event> get_events() const
+  {
+    return events;
+  }
+
+  // Total and longest time the application took to handle a replayed event
+  [[nodiscard]] std::chrono::nanoseconds get_busy_time() const
+  {
+    return busy;
+  }
+
+  [[nodiscard]] std::chrono::nanoseconds get_longest_event() const
+  {
+    return longest;
+  }
+
+  // Every event takes a few bytes: the time since the previous one, the reason and the value
+  bool save(const c_string_view PATH) const
+  {
+    std::string out { MAGIC };
+    std::chrono::microseconds previous { 0 };
+    for (const auto& [TIME, REASON, VALUE, EXPIRED] : events) {
+      put_varint(out, static_cast<unsigned long long>((TIME - previous).count()));
+      out += static_cast<char>(static_cast<unsigned>(REASON) | (EXPIRED ? 0x80U : 0U));
+      put_varint(out, (static_cast<unsigned long long>(VALUE) << 1U) ^ static_cast<unsigned long long>(VALUE >> 31)); // zigzag
+      previous = TIME;
+    }
+
+    const int FILE_DESCRIPTOR { open(PATH.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) }; // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-signed-bitwise)
+    if (FILE_DESCRIPTOR == -1) {
+      return false;
+    }
+
+    std::string_view left { out };
+    while (not left.empty()) {
+      const auto WRITTEN { write(FILE_DESCRIPTOR, left.data(), left.size()) };
+      if (WRITTEN <= 0 and errno != EINTR) {
+        break;
+      }
+      left.remove_prefix(static_cast<size_t>(std::max<ssize_t>(WRITTEN, 0)));
+    }
+
+    return close(FILE_DESCRIPTOR) == 0 and left.empty();
+  }
+
+  // Replaces the events with the ones saved in PATH, returns false if it isn't a valid log
+  bool load(const c_string_view PATH)
+  {
+    const int FILE_DESCRIPTOR { open(PATH.c_str(), O_RDONLY | O_CLOEXEC) }; // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-signed-bitwise)
+    if (FILE_DESCRIPTOR == -1) {
+      return false;
+    }
+
+    std::string in;
+    std::array<char, 1U << 16U> buffer {};
+    for (;;) {
+      const auto READ { read(FILE_DESCRIPTOR, buffer.data(), buffer.size()) };
+      if (READ < 0 and errno == EINTR) {
+        continue;
+      }
+      if (READ <= 0) {
+        break;
+      }
+      in.append(buffer.data(), static_cast<size_t>(READ));
+    }
+    close(FILE_DESCRIPTOR);
+
+    std::string_view left { in };
+    if (not left.starts_with(MAGIC)) {
+      return false;
+    }
+    left.remove_prefix(MAGIC.size());
+
+    std::vector<event> loaded;
+    std::chrono::microseconds time { 0 };
+    while (not left.empty()) {
+      const auto DELTA { get_varint(left) };
+      if (not DELTA or left.empty()) {
+        return false;
+      }
+      const auto REASON { static_cast<unsigned char>(left.front()) };
+      left.remove_prefix(1);
+      const auto VALUE { get_varint(left) };
+      if (not VALUE) {
+        return false;
+      }
+
+      time += std::chrono::microseconds { *DELTA };
+      loaded.push_back({ time, static_cast<exit_reason>(REASON & 0x7FU), static_cast<int>((*VALUE >> 1U) ^ (0 - (*VALUE & 1U))), (REASON & 0x80U) != 0 });
+    }
+
+    events = std::move(loaded);
+    rewind();
+    return true;
+  }
+};
+
+class form : public component {
+  std::vector<std::pair<int, std::function<void()>>> fd_handlers;
+
+  // Looked up by the raw exit data, so routing an exit doesn't build an exit_info
+  std::unordered_map<newtComponent, std::function<bool()>> component_handlers;
+  std::unordered_map<int, std::function<bool()>> hot_key_handlers;
+
+  /*
+   * Repeated keys aren't handled one at a time: while newt keeps returning buffered keys
+   * their count is accumulated, and a 1ms timer exit tells that the buffer is empty.
+   * Then the handler is called once with the count, so the form is redrawn once
+   */
+  struct repeat_handler {
+    std::function<void(int)> handler;
+    bool accelerate;
+  };
+
+  std::unordered_map<int, repeat_handler> repeat_handlers;
+  int pending_key { 0 };
+  int pending_steps { 0 };
+  timer_wheel::clock::time_point held_since;
+  timer_wheel::clock::time_point last_repeat;
+
+  /*
+   * newt has a single timer per form, it ticks the wheel while there are timers in it,
+   * otherwise it's the plain timer set with set_timer()
+   */
+  timer_wheel timers;
+  std::chrono::milliseconds timer_period { 0 };
+  timer_wheel::clock::time_point timer_deadline;
+
+  // While replaying newt isn't run, the exits come from the session
+  session_log* session { nullptr };
+  const session_log::event* replayed { nullptr };
+  bool replaying { false };
+  bool realtime { true };
+
+  // Only the components added while a session is attached are known, by the order they were added in
+  std::vector<newtComponent> members;
+  std::unordered_map<newtComponent, int> member_positions;
+
+  // The time of the replayed event, so a replay takes the decisions of the recorded run
+  [[nodiscard]] timer_wheel::clock::time_point now() const
+  {
+    return replaying ? session->time_of(*replayed) : timer_wheel::clock::now();
+  }
+
+  void next_exit(newtExitStruct& RESULT)
+  {
+    if (replaying) {
+      replay_exit(RESULT);
+      return;
+    }
+
+    NEWTPP_CALL(newtFormRun)(*data, &RESULT);
+
+    // Timers are recorded by on_timer(), with the ticks
+    if (session != nullptr and RESULT.reason != newtExitStruct::NEWT_EXIT_TIMER) {
+      session->record(recorded(RESULT));
+    }
+  }
+
+  [[nodiscard]] session_log::event recorded(const newtExitStruct& RESULT)
+  {
+    const auto TIME { session->elapsed() };
+    switch (RESULT.reason) {
+    case newtExitStruct::NEWT_EXIT_HOTKEY:
+      return { TIME, exit_reason::HOTKEY, RESULT.u.key, false };
+    case newtExitStruct::NEWT_EXIT_FDREADY:
+      return { TIME, exit_reason::FDREADY, RESULT.u.watch, false };
+    case newtExitStruct::NEWT_EXIT_COMPONENT:
+      // Components of nested forms aren't known, they are recorded as errors
+      if (const auto MEMBER { member_positions.find(RESULT.u.co) }; MEMBER != member_positions.end()) {
+        return { TIME, exit_reason::COMPONENT, MEMBER->second, false };
+      }
+      [[fallthrough]];
+    default:
+      return { TIME, exit_reason::ERROR, -1, false };
+    }
+  }
+
+  // Draws the form as newtFormRun would, and returns the next event of the session
+  void replay_exit(newtExitStruct& RESULT)
+  {
+    RESULT = {};
+    replayed = session->next(realtime);
+    if (replayed == nullptr) {
+      stop_session();
+      RESULT.reason = newtExitStruct::NEWT_EXIT_ERROR;
+      return;
+    }
+
+    draw_form();
+    refresh();
+
+    const auto& [TIME, REASON, VALUE, EXPIRED] = *replayed;
+    switch (REASON) {
+    case exit_reason::HOTKEY:
+      RESULT.reason = newtExitStruct::NEWT_EXIT_HOTKEY;
+      RESULT.u.key = VALUE;
+      break;
+    case exit_reason::COMPONENT:
+      if (VALUE >= 0 and static_cast<size_t>(VALUE) < members.size()) {
+        RESULT.reason = newtExitStruct::NEWT_EXIT_COMPONENT;
+        RESULT.u.co = members[static_cast<size_t>(VALUE)];
+      } else {
+        RESULT.reason = newtExitStruct::NEWT_EXIT_ERROR;
+      }
+      break;
+    case exit_reason::FDREADY:
+      RESULT.reason = newtExitStruct::NEWT_EXIT_FDREADY;
+      RESULT.u.watch = VALUE;
+      break;
+    case exit_reason::TIMER:
+      RESULT.reason = newtExitStruct::NEWT_EXIT_TIMER;
+      break;
+    case exit_reason::ERROR:
+    default:
+      RESULT.reason = newtExitStruct::NEWT_EXIT_ERROR;
+      break;
+    }
+  }
+
+  void arm_timer()
+  {
+    const auto PERIOD { timers.empty() ? timer_period : timers.get_resolution() };
+    NEWTPP_CALL(newtFormSetTimer)(*data, static_cast<int>(PERIOD.count()));
+  }
+
+  // Returns true if the plain timer expired, so the exit has to be reported
+  bool on_timer()
+  {
+    if (replaying) {
+      const auto [TIME, REASON, TICKS, EXPIRED] = *replayed;
+      timers.advance(static_cast<unsigned long long>(std::max(TICKS, 0)));
+      return EXPIRED;
+    }
+
+    const auto TICKS { timers.advance() };
+    const bool EXPIRED { timer_period.count() != 0 and timer_wheel::clock::now() >= timer_deadline };
+    if (EXPIRED) {
+      timer_deadline = timer_wheel::clock::now() + timer_period;
+    }
+
+    if (session != nullptr) {
+      session->record({ session->elapsed(), exit_reason::TIMER, static_cast<int>(std::min<unsigned long long>(TICKS, std::numeric_limits<int>::max())), EXPIRED });
+    }
+
+    return EXPIRED;
+  }
+
+  /*
+   * Runs newt until an exit that isn't handled by the form itself.
+   * When polling newt's timer only means that the input was consumed, so it returns nothing
+   */
+  std::optional<newtExitStruct> run_loop(const bool POLL = false)
+  {
+    staging_arena::local().reset();
+
+    newtExitStruct result {};
+    for (;;) {
+      next_exit(result);
+
+      if (result.reason == newtExitStruct::NEWT_EXIT_HOTKEY and repeat(result.u.key)) {
+        continue;
+      }
+
+      // Anything else means that the buffered repeats are over
+      flush_repeats();
+
+      if (result.reason == newtExitStruct::NEWT_EXIT_COMPONENT and handled(component_handlers, result.u.co)) {
+        continue;
+      }
+
+      if (result.reason == newtExitStruct::NEWT_EXIT_HOTKEY and handled(hot_key_handlers, result.u.key)) {
+        continue;
+      }
+
+      if (result.reason == newtExitStruct::NEWT_EXIT_FDREADY) {
+        const auto HANDLER { std::find_if(fd_handlers.begin(), fd_handlers.end(), [&](const auto& WATCHED) { return WATCHED.first == result.u.watch; }) };
+        if (HANDLER != fd_handlers.end()) {
+          HANDLER->second();
+          continue;
+        }
+      }
+
+      if (result.reason == newtExitStruct::NEWT_EXIT_TIMER) {
+        if (on_timer()) {
+          return result;
+        }
+        if (POLL) {
+          return std::nullopt;
+        }
+        arm_timer();
+        continue;
+      }
+
+      return result;
+    }
+  }
+
+  bool repeat(const int KEY)
+  {
+    if (repeat_handlers.empty() or not repeat_handlers.contains(KEY)) {
+      return false;
+    }
+
+    if (KEY != pending_key) {
+      flush_repeats();
+    }
+
+    // A key is held if it's repeated before the terminal repeat delay, 500ms on most terminals
+    const auto NOW { now() };
+    if (KEY != pending_key or NOW - last_repeat > std::chrono::milliseconds { 500 }) {
+      held_since = NOW;
+    }
+
+    pending_key = KEY;
+    last_repeat = NOW;
+    ++pending_steps;
+    NEWTPP_CALL(newtFormSetTimer)(*data, 1);
+
+    return true;
+  }
+
+  void flush_repeats()
+  {
+    if (pending_steps == 0) {
+      return;
+    }
+
+    const auto& [HANDLER, ACCELERATE] = repeat_handlers.at(pending_key);
+    const auto HELD { std::chrono::duration_cast<std::chrono::milliseconds>(last_repeat - held_since) };
+    const int SPEED { ACCELERATE ? static_cast<int>(std::min<long long>(1 + HELD.count() / 250, 8)) : 1 };
+    const int STEPS { pending_steps * SPEED };
+
+    // newt's timer is set back by the next timer exit
+    pending_steps = 0;
+    HANDLER(STEPS);
+  }
+
+  // Returns true if a handler for KEY asked to keep the form running
+  template <typename key_type>
+  static bool handled(const std::unordered_map<key_type, std::function<bool()>>& HANDLERS, const key_type KEY)
+  {
+    if (HANDLERS.empty()) {
+      return false;
+    }
+
+    const auto HANDLER { HANDLERS.find(KEY) };
+    return HANDLER != HANDLERS.end() and HANDLER->second();
+  }
+
+  class event_awaiter {
+    form& owner;
+    event_loop& loop;
+    newtExitStruct result {};
+    std::shared_ptr<bool> waiting;
+
+    void wait(std::coroutine_handle<> HANDLE)
+    {
+      waiting = std::make_shared<bool>(true);
+      const auto READY { [this, HANDLE, WAITING = waiting]() {
+        if (not *WAITING) {
+          return;
+        }
+
+        cancel();
+        if (owner.pump(result)) {
+          HANDLE.resume();
+        } else {
+          wait(HANDLE);
+        }
+      } };
+
+      loop.when_readable(STDIN_FILENO, READY);
+      for (const auto& [FILE_DESCRIPTOR, HANDLER] : owner.fd_handlers) {
+        loop.when_readable(FILE_DESCRIPTOR, READY);
+      }
+
+      const auto PERIOD { owner.timers.empty() ? owner.timer_period : owner.timers.get_resolution() };
+      if (PERIOD.count() != 0) {
+        loop.when_elapsed(PERIOD, READY);
+      }
+    }
+
+    void cancel()
+    {
+      *waiting = false;
+      loop.cancel(STDIN_FILENO);
+      for (const auto& [FILE_DESCRIPTOR, HANDLER] : owner.fd_handlers) {
+        loop.cancel(FILE_DESCRIPTOR);
+      }
+    }
+
+    public:
+    event_awaiter(form& OWNER, event_loop& LOOP)
+        : owner(OWNER)
+        , loop(LOOP)
+    {
+    }
+
+    // The form gets drawn once before waiting, as run() would do
+    bool await_ready() { return owner.pump(result); }
+    void await_suspend(std::coroutine_handle<> HANDLE) { wait(HANDLE); }
+    exit_info await_resume() const { return exit_info { result }; }
+  };
+
+  /*
+   * Processes the input already available and returns false if it didn't make the form exit.
+   * newt has no non blocking run, a 1 ms timer makes newtFormRun return once the input is consumed.
+   * It's only called once the event loop saw stdin, a watched fd or a form timer ready, so an idle
+   * form doesn't poll, but every wakeup that doesn't exit blocks the loop for about 1 ms
+   */
+  bool pump(newtExitStruct& RESULT)
+  {
+    NEWTPP_CALL(newtFormSetTimer)(*data, 1);
+    const auto EXIT { run_loop(true) };
+    arm_timer();
+
+    if (EXIT) {
+      RESULT = *EXIT;
+    }
+    return EXIT.has_value();
+  }
+
+  public:
+  explicit form(void* help_tag = nullptr, const int FLAGS = 0) noexcept
+      : component(NEWTPP_CALL(newtForm)(nullptr, help_tag, FLAGS))
+  {
+  }
+
+  /* TODO:  what the fuck is helptag? <02-04-23, Giuseppe> */
+  explicit form(scroll_bar& bar, void* help_tag = nullptr, const int FLAGS = 0) noexcept
+      : component(NEWTPP_CALL(newtForm)(bar.own(), help_tag, FLAGS))
+  {
+    /* TODO: Implement parameters support <29-03-23, Giuseppe> */
+  }
+
+  template <component_range... ranges>
+  explicit form(ranges&... components) noexcept
+      : component(NEWTPP_CALL(newtForm)(nullptr, nullptr, 0))
+  {
+    add_components(components...);
+  }
+
+  template <component_range... ranges>
+  void add_components(ranges&... components)
+  {
+    auto add { [&]<component_range range>(range& COMPONENTS) {
+      auto added { components_of(COMPONENTS) };
+      if (session != nullptr) {
+        members.reserve(members.size() + added.size());
+        member_positions.reserve(members.size() + added.size());
+        for (const auto& COMPONENT : added) {
+          member_positions.try_emplace(*COMPONENT, static_cast<int>(members.size()));
+          members.push_back(*COMPONENT);
+        }
+      }
+
+      for (auto& comp : added) {
+        NEWTPP_CALL(newtFormAddComponent)(*data, comp.own());
+      }
+    } };
+
+    (add(components), ...);
+  }
+
+  exit_info run()
+  {
+    return exit_info { *run_loop() };
+  }
+
+  /*
+   * run() logs its exits to LOG, forms recording in the same log can be replayed together.
+   * The exits of components are logged only for the components added after this call
+   */
+  void record(session_log& LOG)
+  {
+    session = &LOG;
+    replaying = false;
+  }
+
+  /*
+   * run() takes the exits from LOG instead of newt, at their recorded pace if REALTIME or as fast
+   * as possible, and returns an ERROR exit when they are over. Only run() replays, not next_event().
+   * The components must be added after this call, in the order they were added while recording
+   */
+  void replay(session_log& LOG, const bool REALTIME = true)
+  {
+    session = &LOG;
+    replaying = true;
+    realtime = REALTIME;
+  }
+
+  void stop_session()
+  {
+    session = nullptr;
+    replaying = false;
+    replayed = nullptr;
+  }
+
+  [[nodiscard]] bool is_replaying() const
+  {
+    return replaying;
+  }
+
+  // Awaitable version of run(), LOOP dispatches the input and the watched fds while the coroutine is suspended
+  [[nodiscard]] event_awaiter next_event(event_loop& LOOP)
+  {
+    return event_awaiter { *this, LOOP };
+  }
+
+  void set_timer(const int MILLISECONDS)
+  {
+    timer_period = std::chrono::milliseconds { std::max(MILLISECONDS, 0) };
+    timer_deadline = timer_wheel::clock::now() + timer_period;
+    arm_timer();
+  }
+
+  // CALLBACK is called by run() after PERIOD, and then every PERIOD if REPEAT is true
+  timer_wheel::timer_id add_timer(const std::chrono::milliseconds PERIOD, std::function<void()> CALLBACK, const bool REPEAT = true)
+  {
+    const auto ID { timers.add(PERIOD, std::move(CALLBACK), REPEAT) };
+    arm_timer();
+    return ID;
+  }
+
+  void cancel_timer(const timer_wheel::timer_id ID)
+  {
+    timers.cancel(ID);
+    arm_timer();
+  }
+
+  // The timers already added are kept, with the time they have left rounded up to RESOLUTION
+  void set_timer_resolution(const std::chrono::milliseconds RESOLUTION)
+  {
+    timers.set_resolution(RESOLUTION);
+    arm_timer();
+  }
+
+  void add_hot_key(const int KEY)
+  {
+    NEWTPP_CALL(newtFormAddHotKey)(*data, KEY);
+  }
+
+  // run() calls HANDLER when KEY is pressed, and goes back waiting if it returns true
+  void add_hot_key(const int KEY, std::function<bool()> HANDLER)
+  {
+    NEWTPP_CALL(newtFormAddHotKey)(*data, KEY);
+    hot_key_handlers.insert_or_assign(KEY, std::move(HANDLER));
+  }
+
+  /*
+   * run() calls HANDLER with the number of times KEY was pressed, the repeats that were
+   * buffered while the form was busy are handled in a single call. With ACCELERATE the
+   * steps grow up to 8 times while the key is held
+   */
+  void add_repeat_key(const int KEY, std::function<void(int)> HANDLER, const bool ACCELERATE = false)
+  {
+    NEWTPP_CALL(newtFormAddHotKey)(*data, KEY);
+    repeat_handlers.insert_or_assign(KEY, repeat_handler { std::move(HANDLER), ACCELERATE });
+  }
+
+  // run() calls HANDLER when COMP makes the form exit, and goes back waiting if it returns true
+  template <generic_component component_t>
+  void add_handler(const component_t& COMP, std::function<bool()> HANDLER)
+  {
+    component_handlers.insert_or_assign(*COMP, std::move(HANDLER));
+  }
+
+  template <generic_component component_t>
+  void remove_handler(const component_t& COMP)
+  {
+    component_handlers.erase(*COMP);
+  }
+
+  void watch_fd(const int FILE_DESCRIPTOR, const int FLAGS)
+  {
+    NEWTPP_CALL(newtFormWatchFd)(*data, FILE_DESCRIPTOR, FLAGS);
+  }
+
+  // run() calls HANDLER and goes back waiting when FILE_DESCRIPTOR is ready instead of exiting
+  void watch_fd(const int FILE_DESCRIPTOR, const int FLAGS, std::function<void()> HANDLER)
+  {
+    NEWTPP_CALL(newtFormWatchFd)(*data, FILE_DESCRIPTOR, FLAGS);
+    fd_handlers.emplace_back(FILE_DESCRIPTOR, std::move(HANDLER));
+  }
+
+  // newt has no way to remove a watched fd, a fd watched without flags is ignored
+  void unwatch_fd(const int FILE_DESCRIPTOR)
+  {
+    NEWTPP_CALL(newtFormWatchFd)(*data, FILE_DESCRIPTOR, 0);
+    std::erase_if(fd_handlers, [&](const auto& WATCHED) { return WATCHED.first == FILE_DESCRIPTOR; });
+  }
+
+  void draw_form()
+  {
+    NEWTPP_CALL(newtDrawForm)(*data);
+  }
+
+  template <generic_component component_t>
+  void set_current(const component_t& comp)
+  {
+    NEWTPP_CALL(newtFormSetCurrent)(*data, *comp);
+  }
+
+  void set_background(const int COLOR)
+  {
+    NEWTPP_CALL(newtFormSetBackground)(*data, COLOR);
+  }
+
+  void set_height(const int HEIGHT)
+  {
+    NEWTPP_CALL(newtFormSetHeight)(*data, HEIGHT);
+  }
+
+  void set_width(const int WIDTH)
+  {
+    NEWTPP_CALL(newtFormSetWidth)(*data, WIDTH);
   }
 
   component get_current()
   {
-    return component { newtFormGetCurrent(*data), component::ptr_type::no_delete };
+    return component { NEWTPP_CALL(newtFormGetCurrent)(*data), ownership::BORROWED };
+  }
+};
+
+template <component_range... ranges>
+[[nodiscard]] inline std::pair<exit_info, form> fast_run(const int COLS, const int ROWS, const c_string_view TITLE, ranges&... components)
+{
+  const grid GRID { COLS, ROWS, components... };
+  const window WINDOW { GRID, TITLE };
+  form user_form { components... };
+
+  return { user_form.run(), std::move(user_form) };
+}
+
+// Same as above with the grid shape checked at compile time
+template <int COLS, int ROWS, statically_sized_components... ranges>
+[[nodiscard]] inline std::pair<exit_info, form> fast_run(const c_string_view TITLE, ranges&... components)
+{
+  const static_grid<COLS, ROWS> GRID { components... };
+  const window WINDOW { GRID, TITLE };
+  form user_form { components... };
+
+  return { user_form.run(), std::move(user_form) };
+}
+
+class button : public component {
+  public:
+  explicit button(const c_string_view TEXT, const position POS = { 0, 0 }) noexcept
+      : component(NEWTPP_CALL(newtButton)(POS.left, POS.top, TEXT.c_str()))
+  {
+  }
+};
+
+class compact_button : public component {
+  public:
+  explicit compact_button(const c_string_view TEXT, const position POS = { 0, 0 }) noexcept
+      : component(NEWTPP_CALL(newtCompactButton)(POS.left, POS.top, TEXT.c_str()))
+  {
+  }
+};
+
+class label : public component {
+  public:
+  explicit label(const c_string_view TEXT, const position POS = { 0, 0 }) noexcept
+      : component(NEWTPP_CALL(newtLabel)(POS.left, POS.top, TEXT.c_str()))
+  {
+  }
+
+  void set_text(const c_string_view TEXT)
+  {
+    NEWTPP_CALL(newtLabelSetText)(*data, TEXT.c_str());
+  }
+
+  void set_colors(const int COLOR_SET)
+  {
+    NEWTPP_CALL(newtLabelSetColors)(*data, COLOR_SET);
+  }
+};
+
+class entrybox : public component {
+  const char* content;
+
+  public:
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init, hicpp-member-init, hicpp-signed-bitwise) -- content gets initted by newtEntry
+  explicit entrybox(const int WIDTH, const position POS = { 0, 0 }, const c_string_view INITIAL_VALUE = { "" }, const int FLAGS = NEWT_ENTRY_SCROLL) noexcept
+      : component(NEWTPP_CALL(newtEntry)(POS.left, POS.top, INITIAL_VALUE.c_str(), WIDTH, &content, FLAGS))
+  {
+  }
+
+  void set_value(const c_string_view TEXT, const bool CURSOR_AT_END = true)
+  {
+    NEWTPP_CALL(newtEntrySet)(*data, TEXT.c_str(), static_cast<int>(CURSOR_AT_END));
+  }
+
+  std::string_view get_value()
+  {
+    return std::string_view { content };
+  }
+
+  /* TODO: Add filter api  <29-03-23, Giuseppe> */
+};
+
+class checkbox : public component {
+  public:
+  explicit checkbox(const c_string_view TEXT, const position POS = { 0, 0 }, const char DEFAULT_VAL = ' ', const c_string_view SEQ = {}) noexcept
+      : component(NEWTPP_CALL(newtCheckbox)(POS.left, POS.top, TEXT.c_str(), DEFAULT_VAL, SEQ.c_str(), nullptr))
+  {
+  }
+
+  char get_value()
+  {
+    return NEWTPP_CALL(newtCheckboxGetValue)(*data);
+  }
+
+  void set_value(const char VALUE)
+  {
+    NEWTPP_CALL(newtCheckboxSetValue)(*data, VALUE);
+  }
+
+  /* TODO: add set_flags flags <30-03-23, Giuseppe> */
+};
+
+class radio_button : public component {
+  explicit radio_button(newtComponent other, const ownership OWNERSHIP = ownership::OWNED)
+      : component(other, OWNERSHIP)
+  {
+  }
+
+  public:
+  radio_button()
+      : component(nullptr, ownership::BORROWED)
+  {
+  }
+
+  explicit radio_button(const c_string_view TEXT, const position POS = { 0, 0 }, const radio_button& PREVIUS = {}, bool IS_DEFAULT = false) noexcept
+      : component(NEWTPP_CALL(newtRadiobutton)(POS.left, POS.top, TEXT.c_str(), static_cast<int>(IS_DEFAULT), *PREVIUS))
+  {
+  }
+
+  [[nodiscard]] radio_button get_current() const
+  {
+    return radio_button { NEWTPP_CALL(newtRadioGetCurrent)(*data), ownership::BORROWED };
+  }
+
+  void set_current()
+  {
+    NEWTPP_CALL(newtRadioSetCurrent)(*data);
+  }
+};
+
+class radio_button_collection {
+  std::vector<radio_button> collection {};
+  std::unordered_map<newtComponent, size_t> indexes {};
+
+  public:
+  template <std::convertible_to<c_string_view>... T>
+  explicit radio_button_collection(T... strings)
+  {
+    (add_radio_button(strings), ...);
+  }
+
+  template <std::ranges::input_range range>
+    requires std::convertible_to<std::ranges::range_reference_t<const range>, c_string_view>
+  explicit radio_button_collection(const range& STRINGS)
+  {
+    add_radio_buttons(STRINGS);
+  }
+
+  // Only valid as long as radio_button adds no state on top of component
+  static_assert(sizeof(radio_button) == sizeof(component));
+
+  std::span<component> as_range()
+  {
+    return std::span { reinterpret_cast<component*>(collection.data()), collection.size() };
+  }
+
+  [[nodiscard]] std::span<const component> as_range() const
+  {
+    return std::span { reinterpret_cast<const component*>(collection.data()), collection.size() };
+  }
+
+  // Returns the size of the collection if no radio button is selected
+  [[nodiscard]] size_t get_current_index() const
+  {
+    if (collection.empty()) {
+      return 0;
+    }
+
+    const auto CURRENT { indexes.find(NEWTPP_CALL(newtRadioGetCurrent)(*collection.front())) };
+    return (CURRENT == indexes.end()) ? collection.size() : CURRENT->second;
+  }
+
+  void set_current(const size_t INDEX)
+  {
+    collection[INDEX].set_current();
+  }
+
+  template <typename... T>
+  void add_radio_button(const c_string_view TEXT, const position POS = { 0, 0 }, const bool DEFAULT = false)
+  {
+    collection.empty()
+        ? collection.emplace_back(TEXT, POS, radio_button {}, DEFAULT)
+        : collection.emplace_back(TEXT, POS, collection.back(), DEFAULT);
+
+    indexes.emplace(*collection.back(), collection.size() - 1);
+  }
+
+  template <std::ranges::input_range range>
+    requires std::convertible_to<std::ranges::range_reference_t<const range>, c_string_view>
+  void add_radio_buttons(const range& STRINGS)
+  {
+    if constexpr (std::ranges::sized_range<const range>) {
+      const size_t SIZE { collection.size() + static_cast<size_t>(std::ranges::size(STRINGS)) };
+      collection.reserve(SIZE);
+      indexes.reserve(SIZE);
+    }
+
+    for (const auto& TEXT : STRINGS) {
+      add_radio_button(TEXT);
+    }
+  }
+};
+
+class scale : public component {
+  int width;
+  long long full_value;
+
+  public:
+  scale(const int WIDTH, const long long FULL_VALUE, const position POS = { 0, 0 }) noexcept
+      : component(NEWTPP_CALL(newtScale)(POS.left, POS.top, WIDTH, FULL_VALUE))
+      , width(WIDTH)
+      , full_value(FULL_VALUE)
+  {
+  }
+
+  void set_value(const unsigned long long VALUE)
+  {
+    NEWTPP_CALL(newtScaleSet)(*data, VALUE);
+  }
+
+  [[nodiscard]] int get_width() const
+  {
+    return width;
+  }
+
+  [[nodiscard]] long long get_full_value() const
+  {
+    return full_value;
+  }
+};
+
+class textbox : public component {
+  public:
+  explicit textbox(const size SIZE, const c_string_view TEXT, const position POS = { 0, 0 }, const bool IS_SCROLLABLE = true) noexcept
+      // NOLINTNEXTLINE
+      : component(NEWTPP_CALL(newtTextbox)(POS.left, POS.top, SIZE.width, SIZE.height, (IS_SCROLLABLE) ? NEWT_FLAG_SCROLL : 0))
+  {
+    NEWTPP_CALL(newtTextboxSetText)(*data, TEXT.c_str());
+  }
+
+  void set_text(const c_string_view TEXT)
+  {
+    NEWTPP_CALL(newtTextboxSetText)(*data, TEXT.c_str());
+  }
+
+  void set_height(const int HEIGHT)
+  {
+    NEWTPP_CALL(newtTextboxSetHeight)(*data, HEIGHT);
+  }
+
+  [[nodiscard]] int get_num_lines() const
+  {
+    return NEWTPP_CALL(newtTextboxGetNumLines)(*data);
+  }
+
+  // NOLINTNEXTLINE -- still the best way
+  void set_colors(const int NORMAL, const int ACTIVE)
+  {
+    NEWTPP_CALL(newtTextboxSetColors)(*data, NORMAL, ACTIVE);
+  }
+};
+
+class textbox_reflowed : public component {
+  // newt can't widen a textbox, the width it was created with is the widest the text can get
+  int max_width;
+  reflow_cache reflowed;
+
+  static reflow_cache wrapped(const int WIDTH, const std::string_view TEXT)
+  {
+    reflow_cache cache { WIDTH };
+    cache.set_text(TEXT);
+    return cache;
+  }
+
+  // The text is wrapped once by the cache, newt gets a plain textbox that already fits it
+  textbox_reflowed(reflow_cache CACHE, const position POS) noexcept
+      : component(NEWTPP_CALL(newtTextbox)(POS.left, POS.top, CACHE.get_width(), static_cast<int>(CACHE.get_num_lines()), 0))
+      , max_width(CACHE.get_width())
+      , reflowed(std::move(CACHE))
+  {
+    NEWTPP_CALL(newtTextboxSetText)(*data, reflowed.get_text().c_str());
+  }
+
+  public:
+  // Only the paragraphs that changed get wrapped again, newt receives text that already fits
+  void set_text(const std::string_view TEXT)
+  {
+    reflowed.set_text(TEXT);
+    NEWTPP_CALL(newtTextboxSetText)(*data, reflowed.get_text().c_str());
+  }
+
+  explicit textbox_reflowed(const int WIDTH, const std::string_view TEXT, const position POS = { 0, 0 }) noexcept
+      : textbox_reflowed(wrapped(WIDTH, TEXT), POS)
+  {
+  }
+
+  // Wraps the text again at WIDTH, capped to the width given to the constructor, and fits the height to it
+  void set_width(const int WIDTH)
+  {
+    reflowed.set_width(std::min(WIDTH, max_width));
+    NEWTPP_CALL(newtTextboxSetHeight)(*data, static_cast<int>(reflowed.get_num_lines()));
+    NEWTPP_CALL(newtTextboxSetText)(*data, reflowed.get_text().c_str());
+  }
+
+  void set_height(const int HEIGHT)
+  {
+    NEWTPP_CALL(newtTextboxSetHeight)(*data, HEIGHT);
+  }
+
+  [[nodiscard]] int get_num_lines() const
+  {
+    return NEWTPP_CALL(newtTextboxGetNumLines)(*data);
+  }
+
+  // NOLINTNEXTLINE -- still the best way
+  void set_colors(const int NORMAL, const int ACTIVE)
+  {
+    NEWTPP_CALL(newtTextboxSetColors)(*data, NORMAL, ACTIVE);
+  }
+};
+
+// newt cuts the line at the textbox width anyway, utf-8 takes at most 4 bytes per column
+[[nodiscard]] inline std::string_view truncate_to_width(const std::string_view LINE, const int WIDTH)
+{
+  size_t length { std::min(LINE.size(), static_cast<size_t>(std::max(WIDTH, 0)) * 4) };
+  while (length < LINE.size() and length > 0 and (static_cast<unsigned char>(LINE[length]) & 0xC0U) == 0x80U) {
+    --length;
+  }
+
+  return LINE.substr(0, length);
+}
+
+class log_textbox : public component {
+  /*
+   * Fixed capacity ring of lines, newt only gets the lines that are visible
+   * so the cost of an update depends on the height and not on the history
+   */
+  std::vector<std::string> lines;
+  size_t oldest { 0 };
+  size_t stored { 0 };
+  size_t scrolled { 0 }; // lines between the bottom of the view and the newest line
+  int width;
+  int height;
+  std::string screen;
+  bool dirty { true };
+
+  std::string& line_at(const size_t INDEX)
+  {
+    return lines[(oldest + INDEX) % lines.size()];
+  }
+
+  size_t max_scroll() const
+  {
+    return stored - std::min(stored, static_cast<size_t>(height));
+  }
+
+  void push_line(const std::string_view LINE)
+  {
+    const auto VISIBLE { truncate_to_width(LINE, width) };
+
+    if (stored < lines.size()) {
+      line_at(stored++).assign(VISIBLE);
+    } else {
+      lines[oldest].assign(VISIBLE);
+      oldest = (oldest + 1) % lines.size();
+    }
+
+    // A scrolled view keeps showing the same lines, unless they fall out of the ring
+    if (scrolled == 0) {
+      dirty = true;
+    } else if (scrolled < max_scroll()) {
+      ++scrolled;
+    } else {
+      dirty = true;
+    }
+  }
+
+  public:
+  log_textbox(const size SIZE, const size_t CAPACITY, const position POS = { 0, 0 }) noexcept
+      : component(NEWTPP_CALL(newtTextbox)(POS.left, POS.top, SIZE.width, SIZE.height, 0))
+      , lines(std::max<size_t>(CAPACITY, 1))
+      , width(SIZE.width)
+      , height(SIZE.height)
+  {
+    screen.reserve(static_cast<size_t>(width + 1) * static_cast<size_t>(height));
+  }
+
+  void append(const std::string_view TEXT)
+  {
+    // A trailing new line doesn't start an empty line
+    size_t begin { 0 };
+    do {
+      const size_t END { std::min(TEXT.find('\n', begin), TEXT.size()) };
+      push_line(TEXT.substr(begin, END - begin));
+      begin = END + 1;
+    } while (begin < TEXT.size());
+  }
+
+  void scroll(const long long LINES)
+  {
+    const auto TARGET { std::clamp(static_cast<long long>(scrolled) + LINES, 0LL, static_cast<long long>(max_scroll())) };
+    dirty = dirty or static_cast<size_t>(TARGET) != scrolled;
+    scrolled = static_cast<size_t>(TARGET);
+  }
+
+  void scroll_to_bottom()
+  {
+    dirty = dirty or scrolled != 0;
+    scrolled = 0;
+  }
+
+  [[nodiscard]] bool is_pinned() const
+  {
+    return scrolled == 0;
+  }
+
+  [[nodiscard]] size_t get_num_lines() const
+  {
+    return stored;
+  }
+
+  void clear()
+  {
+    oldest = stored = scrolled = 0;
+    dirty = true;
+  }
+
+  // Hands the visible lines to newt, does nothing if they didn't change since the last flush
+  void flush()
+  {
+    if (not dirty) {
+      return;
+    }
+
+    const size_t LAST { stored - scrolled };
+    const size_t FIRST { LAST - std::min(LAST, static_cast<size_t>(height)) };
+
+    screen.clear();
+    for (size_t index { FIRST }; index < LAST; ++index) {
+      screen += line_at(index);
+      screen += '\n';
+    }
+    if (not screen.empty()) {
+      screen.pop_back();
+    }
+
+    NEWTPP_CALL(newtTextboxSetText)(*data, screen.c_str());
+    dirty = false;
+  }
+};
+
+/*
+ *         VIRTUALIZED LISTBOX
+ */
+
+class listbox_source {
+  public:
+  listbox_source() = default;
+  listbox_source(const listbox_source&) = default;
+  listbox_source(listbox_source&&) = default;
+  listbox_source& operator=(const listbox_source&) = default;
+  listbox_source& operator=(listbox_source&&) = default;
+  virtual ~listbox_source() = default;
+
+  [[nodiscard]] virtual size_t count() const = 0;
+  [[nodiscard]] virtual std::string row(const size_t INDEX) const = 0;
+};
+
+class listbox : public component {
+  /*
+   * newt only ever holds the rows of the window [first, first + slots), every
+   * entry data pointer is the slot number so the absolute index is first + slot.
+   * The state lives on the heap because newt keeps a pointer to it for the
+   * callback, and it must survive moves of the listbox.
+   */
+  struct view {
+    listbox_source* source;
+    size_t first { 0 };
+    int slots { 0 };
+    int height;
+    int margin;
+    int shown { 0 }; // mirrors newt's startShowItem
+    bool moving { false };
+  };
+
+  std::unique_ptr<view> state;
+
+  static int slot_of(newtComponent LISTBOX)
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+    return static_cast<int>(reinterpret_cast<std::uintptr_t>(NEWTPP_CALL(newtListboxGetCurrent)(LISTBOX)));
+  }
+
+  static void follow(view& VIEW, const int SLOT)
+  {
+    if (SLOT < VIEW.shown) {
+      VIEW.shown = SLOT;
+    } else if (SLOT > VIEW.shown + VIEW.height - 1) {
+      VIEW.shown = SLOT - VIEW.height + 1;
+    }
+  }
+
+  static void fill(newtComponent LISTBOX, view& VIEW)
+  {
+    for (int slot { 0 }; slot < VIEW.slots; ++slot) {
+      NEWTPP_CALL(newtListboxSetEntry)(LISTBOX, slot, VIEW.source->row(VIEW.first + static_cast<size_t>(slot)).c_str());
+    }
+  }
+
+  // Moves the cursor to SLOT keeping the first visible row at SHOWN
+  static void show(newtComponent LISTBOX, view& VIEW, const int SHOWN, const int SLOT)
+  {
+    VIEW.shown = std::clamp(SHOWN, 0, std::max(VIEW.slots - VIEW.height, 0));
+
+    VIEW.moving = true;
+    NEWTPP_CALL(newtListboxSetCurrent)(LISTBOX, 0);
+    NEWTPP_CALL(newtListboxSetCurrent)(LISTBOX, std::min(VIEW.shown + VIEW.height - 1, VIEW.slots - 1));
+    NEWTPP_CALL(newtListboxSetCurrent)(LISTBOX, SLOT);
+    VIEW.moving = false;
+
+    follow(VIEW, SLOT);
+  }
+
+  static void rebuild(newtComponent LISTBOX, view& VIEW, const size_t CURRENT)
+  {
+    const size_t COUNT { VIEW.source->count() };
+    const int SLOTS { static_cast<int>(std::min<size_t>(COUNT, static_cast<size_t>(VIEW.height + 2 * VIEW.margin))) };
+
+    VIEW.moving = true;
+    if (SLOTS != VIEW.slots) {
+      NEWTPP_CALL(newtListboxClear)(LISTBOX);
+      for (int slot { 0 }; slot < SLOTS; ++slot) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+        NEWTPP_CALL(newtListboxAppendEntry)(LISTBOX, "", reinterpret_cast<void*>(static_cast<std::uintptr_t>(slot)));
+      }
+      VIEW.slots = SLOTS;
+    }
+    VIEW.moving = false;
+
+    if (SLOTS == 0) {
+      VIEW.first = 0;
+      return;
+    }
+
+    const size_t TARGET { std::min(CURRENT, COUNT - 1) };
+    VIEW.first = std::min(TARGET - std::min(TARGET, static_cast<size_t>(SLOTS / 2)), COUNT - static_cast<size_t>(SLOTS));
+    fill(LISTBOX, VIEW);
+
+    const int SLOT { static_cast<int>(TARGET - VIEW.first) };
+    show(LISTBOX, VIEW, SLOT - VIEW.height / 2, SLOT);
+  }
+
+  static void on_move(newtComponent LISTBOX, void* user_data)
+  {
+    auto& view_state { *static_cast<view*>(user_data) };
+    if (view_state.moving or view_state.slots == 0) {
+      return;
+    }
+
+    const int SLOT { slot_of(LISTBOX) };
+    follow(view_state, SLOT);
+
+    const size_t COUNT { view_state.source->count() };
+    const bool NEAR_TOP { SLOT < view_state.margin and view_state.first > 0 };
+    const bool NEAR_BOTTOM { SLOT >= view_state.slots - view_state.margin and view_state.first + static_cast<size_t>(view_state.slots) < COUNT };
+    if (not NEAR_TOP and not NEAR_BOTTOM) {
+      return;
+    }
+
+    // Slide the window so the cursor sits in the middle, the visible rows don't move on screen
+    const size_t CURRENT { view_state.first + static_cast<size_t>(SLOT) };
+    const size_t FIRST { std::min(CURRENT - std::min(CURRENT, static_cast<size_t>(view_state.slots / 2)), COUNT - static_cast<size_t>(view_state.slots)) };
+    const auto DELTA { static_cast<int>(static_cast<long long>(FIRST) - static_cast<long long>(view_state.first)) };
+
+    view_state.first = FIRST;
+    fill(LISTBOX, view_state);
+    show(LISTBOX, view_state, view_state.shown - DELTA, SLOT - DELTA);
+  }
+
+  static size_t current_of(newtComponent LISTBOX, const view& VIEW)
+  {
+    return (VIEW.slots == 0) ? 0 : VIEW.first + static_cast<size_t>(slot_of(LISTBOX));
+  }
+
+  static void move_by(newtComponent LISTBOX, view& VIEW, const long long ROWS)
+  {
+    const auto LAST { static_cast<long long>(std::max<size_t>(VIEW.source->count(), 1)) - 1 };
+    rebuild(LISTBOX, VIEW, static_cast<size_t>(std::clamp(static_cast<long long>(current_of(LISTBOX, VIEW)) + ROWS, 0LL, LAST)));
+  }
+
+  public:
+  // NOLINTNEXTLINE(hicpp-signed-bitwise)
+  listbox(const int HEIGHT, listbox_source& SOURCE, const position POS = { 0, 0 }, const int FLAGS = NEWT_FLAG_SCROLL, const int PREFETCH = -1) noexcept
+      : component(NEWTPP_CALL(newtListbox)(POS.left, POS.top, HEIGHT, FLAGS))
+      , state(std::make_unique<view>(view { .source = &SOURCE, .height = HEIGHT, .margin = (PREFETCH < 0) ? HEIGHT : PREFETCH }))
+  {
+    NEWTPP_CALL(newtComponentAddCallback)(*data, on_move, state.get());
+    rebuild(*data, *state, 0);
+  }
+
+  [[nodiscard]] size_t get_current() const
+  {
+    return current_of(*data, *state);
+  }
+
+  void set_current(const size_t INDEX)
+  {
+    rebuild(*data, *state, INDEX);
+  }
+
+  /*
+   * Moves the selection with the arrows and page up/down while FORM runs, with the
+   * repeats buffered over a slow connection coalesced in a single move.
+   * The keys become hot keys of FORM, so they don't move between components anymore
+   */
+  void bind(form& FORM)
+  {
+    newtComponent const LISTBOX { *data };
+    view* const VIEW { state.get() };
+    FORM.add_repeat_key(NEWT_KEY_UP, [LISTBOX, VIEW](const int STEPS) { move_by(LISTBOX, *VIEW, -STEPS); }, true);
+    FORM.add_repeat_key(NEWT_KEY_DOWN, [LISTBOX, VIEW](const int STEPS) { move_by(LISTBOX, *VIEW, STEPS); }, true);
+    FORM.add_repeat_key(NEWT_KEY_PGUP, [LISTBOX, VIEW](const int STEPS) { move_by(LISTBOX, *VIEW, -static_cast<long long>(STEPS) * VIEW->height); });
+    FORM.add_repeat_key(NEWT_KEY_PGDN, [LISTBOX, VIEW](const int STEPS) { move_by(LISTBOX, *VIEW, static_cast<long long>(STEPS) * VIEW->height); });
+  }
+
+  // Must be called after the source changes its rows or its count
+  void reload()
+  {
+    rebuild(*data, *state, get_current());
+  }
+
+  void set_width(const int WIDTH)
+  {
+    NEWTPP_CALL(newtListboxSetWidth)(*data, WIDTH);
+  }
+};
+
+/*
+ *         FRAME SCHEDULING
+ */
+
+class frame_scheduler {
+  public:
+  using clock = std::chrono::steady_clock;
+
+  private:
+  clock::duration interval;
+  clock::time_point last_frame {};
+
+  /*
+   * Updates are kept in scheduling order, the map lets a newer update of the
+   * same component replace the pending one so only the last value gets to newt
+   */
+  std::vector<std::function<void()>> updates;
+  std::unordered_map<const void*, size_t> pending;
+  bool dirty { false };
+
+  form* owner { nullptr };
+  timer_wheel::timer_id timer;
+
+  static clock::duration interval_of(const unsigned int MAX_FPS)
+  {
+    return std::chrono::duration_cast<clock::duration>(std::chrono::seconds { 1 }) / std::max(MAX_FPS, 1U);
+  }
+
+  public:
+  explicit frame_scheduler(const unsigned int MAX_FPS = 30) noexcept
+      : interval(interval_of(MAX_FPS))
+  {
+  }
+
+  frame_scheduler(const frame_scheduler&) = delete;
+  frame_scheduler(frame_scheduler&&) = delete;
+  frame_scheduler& operator=(const frame_scheduler&) = delete;
+  frame_scheduler& operator=(frame_scheduler&&) = delete;
+
+  ~frame_scheduler()
+  {
+    detach();
+  }
+
+  void set_max_fps(const unsigned int MAX_FPS)
+  {
+    interval = interval_of(MAX_FPS);
+    if (owner != nullptr) {
+      attach(*owner);
+    }
+  }
+
+  /*
+   * Polls from a timer of FORM every frame interval while it runs, so the pending updates are
+   * flushed without calling poll(). FORM must outlive the scheduler, or be detached first
+   */
+  void attach(form& FORM)
+  {
+    detach();
+
+    const auto PERIOD { std::max(std::chrono::duration_cast<std::chrono::milliseconds>(interval), std::chrono::milliseconds { 1 }) };
+    owner = &FORM;
+
+    // The timer already keeps the frames an interval apart
+    timer = FORM.add_timer(PERIOD, [this]() {
+      if (dirty) {
+        flush();
+      }
+    });
+  }
+
+  void detach()
+  {
+    if (owner != nullptr) {
+      owner->cancel_timer(timer);
+      owner = nullptr;
+    }
+  }
+
+  void schedule(const void* KEY, std::function<void()> UPDATE)
+  {
+    const auto [IT, INSERTED] { pending.try_emplace(KEY, updates.size()) };
+    if (INSERTED) {
+      updates.push_back(std::move(UPDATE));
+    } else {
+      updates[IT->second] = std::move(UPDATE);
+    }
+
+    dirty = true;
+  }
+
+  template <generic_component component_t>
+  void schedule(const component_t& COMPONENT, std::function<void()> UPDATE)
+  {
+    schedule(static_cast<const void*>(*COMPONENT), std::move(UPDATE));
+  }
+
+  void set_text(label& LABEL, const std::string_view TEXT)
+  {
+    schedule(LABEL, [&LABEL, TEXT = std::string { TEXT }]() { LABEL.set_text(TEXT); });
+  }
+
+  void set_value(entrybox& ENTRY, const std::string_view TEXT, const bool CURSOR_AT_END = true)
+  {
+    schedule(ENTRY, [&ENTRY, TEXT = std::string { TEXT }, CURSOR_AT_END]() { ENTRY.set_value(TEXT, CURSOR_AT_END); });
+  }
+
+  void set_value(scale& SCALE, const unsigned long long VALUE)
+  {
+    schedule(SCALE, [&SCALE, VALUE]() { SCALE.set_value(VALUE); });
+  }
+
+  void set_text(textbox& TEXTBOX, const std::string_view TEXT)
+  {
+    schedule(TEXTBOX, [&TEXTBOX, TEXT = std::string { TEXT }]() { TEXTBOX.set_text(TEXT); });
+  }
+
+  void flush_on_frame(log_textbox& LOG)
+  {
+    schedule(LOG, [&LOG]() { LOG.flush(); });
+  }
+
+  // For changes made directly through newt that only need the screen to be refreshed
+  void mark_dirty()
+  {
+    dirty = true;
+  }
+
+  [[nodiscard]] bool is_dirty() const
+  {
+    return dirty;
+  }
+
+  [[nodiscard]] clock::duration time_to_next_frame() const
+  {
+    const auto ELAPSED { clock::now() - last_frame };
+    return (ELAPSED >= interval) ? clock::duration::zero() : interval - ELAPSED;
+  }
+
+  // Applies the pending updates and refreshes the screen once
+  void flush()
+  {
+    for (auto& update : updates) {
+      update();
+    }
+
+    updates.clear();
+    pending.clear();
+    dirty = false;
+
+    refresh();
+    last_frame = clock::now();
+  }
+
+  // Flushes only if something changed and the last frame is older than the frame interval
+  bool poll()
+  {
+    if (not dirty or time_to_next_frame() != clock::duration::zero()) {
+      return false;
+    }
+
+    flush();
+    return true;
+  }
+};
+
+/*
+ *         THREAD SAFE COMMANDS
+ */
+
+class command_queue {
+  /*
+   * Intrusive multi producer single consumer queue, producers only do an
+   * atomic exchange on head. The consumer is the thread running the form,
+   * woken up by an eventfd watched by the form.
+   */
+  struct node {
+    std::function<void()> command;
+    std::atomic<node*> next { nullptr };
+  };
+
+  node stub;
+  std::atomic<node*> head { &stub };
+  node* tail { &stub };
+
+  int event_fd;
+  std::atomic<bool> signaled { false };
+
+  void push(node* NODE)
+  {
+    NODE->next.store(nullptr, std::memory_order_relaxed);
+    node* const PREVIOUS { head.exchange(NODE, std::memory_order_acq_rel) };
+    PREVIOUS->next.store(NODE, std::memory_order_release);
+  }
+
+  node* pop()
+  {
+    node* last { tail };
+    node* next { last->next.load(std::memory_order_acquire) };
+
+    if (last == &stub) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail = next;
+      last = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+      tail = next;
+      return last;
+    }
+
+    /*
+     * A producer swapped head but didn't link its node yet. post() publishes the node first
+     * and writes the eventfd after, and drain() cleared signaled before popping, so that
+     * write wakes up the form again and the next drain() finds the node linked
+     */
+    if (last != head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+
+    push(&stub);
+    next = last->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail = next;
+      return last;
+    }
+
+    return nullptr;
+  }
+
+  public:
+  command_queue() noexcept
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      : event_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+  {
+  }
+
+  command_queue(const command_queue&) = delete;
+  command_queue(command_queue&&) = delete;
+  command_queue& operator=(const command_queue&) = delete;
+  command_queue& operator=(command_queue&&) = delete;
+
+  ~command_queue()
+  {
+    while (node* const NODE { pop() }) {
+      delete NODE; // NOLINT(cppcoreguidelines-owning-memory)
+    }
+    close(event_fd);
+  }
+
+  // Safe to call from any thread, COMMAND runs on the thread running the form
+  void post(std::function<void()> COMMAND)
+  {
+    push(new node { .command = std::move(COMMAND) }); // NOLINT(cppcoreguidelines-owning-memory)
+
+    if (not signaled.exchange(true, std::memory_order_acq_rel)) {
+      const std::uint64_t ONE { 1 };
+      [[maybe_unused]] const auto WRITTEN { write(event_fd, &ONE, sizeof(ONE)) };
+    }
+  }
+
+  // Runs all the posted commands, must be called from the thread running the form
+  size_t drain()
+  {
+    std::uint64_t counter { 0 };
+    [[maybe_unused]] const auto READ { read(event_fd, &counter, sizeof(counter)) };
+    signaled.exchange(false, std::memory_order_acq_rel);
+
+    size_t executed { 0 };
+    while (node* const NODE { pop() }) {
+      NODE->command();
+      delete NODE; // NOLINT(cppcoreguidelines-owning-memory)
+      ++executed;
+    }
+
+    return executed;
+  }
+
+  void attach(form& FORM)
+  {
+    FORM.watch_fd(event_fd, NEWT_FD_READ, [this]() { drain(); });
+  }
+
+  [[nodiscard]] int get_fd() const
+  {
+    return event_fd;
+  }
+};
+
+/*
+ *         TERMINAL RESIZE
+ */
+
+class resize_manager {
+  public:
+  struct geometry {
+    int left { 0 };
+    int top { 0 };
+    int width { 0 };
+    int height { 0 };
+
+    bool operator==(const geometry&) const = default;
+  };
+
+  private:
+  struct layout {
+    std::function<geometry(size)> compute;
+    std::function<void(const geometry&)> apply;
+    std::optional<geometry> applied;
+  };
+
+  struct tracked_window {
+    newtGrid grid;
+    std::optional<std::string> title;
+    geometry applied;
+    form* shown; // drawn again once the window is reopened, may be null
+  };
+
+  /*
+   * Only async signal safe calls in the handler: it wakes up the form through an eventfd
+   * and chains to the handler installed before the first resize_manager, newt's one
+   */
+  static inline std::atomic<int> signal_fd { -1 };
+  static inline struct sigaction chained { };
+
+  static void on_sigwinch(const int SIGNAL, siginfo_t* const INFO, void* const CONTEXT)
+  {
+    const int SAVED_ERRNO { errno };
+    const std::uint64_t ONE { 1 };
+    [[maybe_unused]] const auto WRITTEN { write(signal_fd.load(std::memory_order_relaxed), &ONE, sizeof(ONE)) };
+    errno = SAVED_ERRNO;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-union-access)
+    if ((static_cast<unsigned int>(chained.sa_flags) & SA_SIGINFO) != 0) {
+      if (chained.sa_sigaction != nullptr) {
+        chained.sa_sigaction(SIGNAL, INFO, CONTEXT);
+      }
+    } else if (chained.sa_handler != SIG_DFL and chained.sa_handler != SIG_IGN) {
+      chained.sa_handler(SIGNAL);
+    }
+    // NOLINTEND(cppcoreguidelines-pro-type-union-access)
+  }
+
+  form& owner;
+  std::chrono::milliseconds settle;
+  int event_fd;
+  int previous_fd;
+  bool installed { false };
+  bool resized { false };
+  std::optional<timer_wheel::timer_id> pending;
+
+  std::vector<layout> layouts;
+  std::vector<tracked_window> windows;
+
+  static int title_width(const std::optional<std::string>& TITLE)
+  {
+    return TITLE ? static_cast<int>(std::ranges::count_if(*TITLE, [](const char BYTE) { return (static_cast<unsigned char>(BYTE) & 0xC0U) != 0x80U; })) : 0;
+  }
+
+  /*
+   * The window newtGridWrappedWindow opens: 2 columns and rows more than the grid for
+   * the border, wide enough for the title, centered the way newtCenteredWindow does it
+   */
+  static geometry centered(const newtGrid GRID, const std::optional<std::string>& TITLE, const size SCREEN)
+  {
+    int width { 0 };
+    int height { 0 };
+    NEWTPP_CALL(newtGridGetSize)(GRID, &width, &height);
+
+    geometry result { .width = std::max(width, title_width(TITLE) + 2) + 2, .height = height + 2 };
+    result.left = (SCREEN.width - result.width) / 2;
+    result.top = (SCREEN.height - result.height) / 2;
+    if (SCREEN.height % 2 != 0 and result.top % 2 != 0) {
+      --result.top;
+    }
+
+    return result;
+  }
+
+  // A burst of signals keeps pushing the relayout back until the terminal stops changing
+  void on_signal()
+  {
+    std::uint64_t counter { 0 };
+    [[maybe_unused]] const auto READ { read(event_fd, &counter, sizeof(counter)) };
+    resized = true;
+
+    if (pending) {
+      owner.cancel_timer(*pending);
+    }
+    pending = owner.add_timer(settle, [this]() { relayout(); }, false);
+  }
+
+  // newt windows are a stack, to move one all the windows above it have to be reopened too
+  void relayout_windows(const size SCREEN)
+  {
+    auto first_changed { windows.size() };
+    for (size_t index { 0 }; index < windows.size(); ++index) {
+      if (centered(windows[index].grid, windows[index].title, SCREEN) != windows[index].applied) {
+        first_changed = index;
+        break;
+      }
+    }
+
+    for (auto index { first_changed }; index < windows.size(); ++index) {
+      NEWTPP_CALL(newtPopWindow)();
+    }
+
+    for (auto index { first_changed }; index < windows.size(); ++index) {
+      auto& [GRID, TITLE, APPLIED, SHOWN] = windows[index];
+      APPLIED = centered(GRID, TITLE, SCREEN);
+
+      // The grid is centered under a title wider than it, as newtGridWrappedWindow does
+      int width { 0 };
+      int height { 0 };
+      NEWTPP_CALL(newtGridGetSize)(GRID, &width, &height);
+      NEWTPP_CALL(newtOpenWindow)(APPLIED.left, APPLIED.top, static_cast<unsigned int>(APPLIED.width), static_cast<unsigned int>(APPLIED.height), TITLE ? TITLE->c_str() : nullptr);
+      NEWTPP_CALL(newtGridPlace)(GRID, 1 + (APPLIED.width - 2 - width) / 2, 1);
+
+      // A reopened window is blank, its form is drawn while it's the current window
+      if (SHOWN != nullptr) {
+        SHOWN->draw_form();
+      }
+    }
+  }
+
+  public:
+  /*
+   * Reacts to SIGWINCH while FORM runs. SETTLE is how long the terminal size has to
+   * stay the same before relaying out. FORM must outlive the resize_manager
+   */
+  explicit resize_manager(form& FORM, const std::chrono::milliseconds SETTLE = std::chrono::milliseconds { 100 }) noexcept
+      : owner(FORM)
+      , settle(SETTLE)
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      , event_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+      , previous_fd(signal_fd.exchange(event_fd))
+  {
+    struct sigaction action { };
+    action.sa_sigaction = on_sigwinch; // NOLINT(cppcoreguidelines-pro-type-union-access)
+    action.sa_flags = SA_SIGINFO | SA_RESTART; // NOLINT(hicpp-signed-bitwise)
+    sigemptyset(&action.sa_mask);
+
+    struct sigaction previous { };
+    sigaction(SIGWINCH, &action, &previous);
+
+    // Nested managers share the handler, only the outermost one restores the previous one
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-union-access)
+    if ((static_cast<unsigned int>(previous.sa_flags) & SA_SIGINFO) == 0 or previous.sa_sigaction != on_sigwinch) {
+      chained = previous;
+      installed = true;
+    }
+
+    owner.watch_fd(event_fd, NEWT_FD_READ, [this]() { on_signal(); });
+  }
+
+  resize_manager(const resize_manager&) = delete;
+  resize_manager(resize_manager&&) = delete;
+  resize_manager& operator=(const resize_manager&) = delete;
+  resize_manager& operator=(resize_manager&&) = delete;
+
+  ~resize_manager()
+  {
+    if (installed) {
+      sigaction(SIGWINCH, &chained, nullptr);
+    }
+    signal_fd.store(previous_fd);
+
+    // The enclosing manager missed the resizes that happened meanwhile
+    if (resized and previous_fd != -1) {
+      const std::uint64_t ONE { 1 };
+      [[maybe_unused]] const auto WRITTEN { write(previous_fd, &ONE, sizeof(ONE)) };
+    }
+
+    if (pending) {
+      owner.cancel_timer(*pending);
+    }
+    owner.unwatch_fd(event_fd);
+    close(event_fd);
+  }
+
+  // On resize APPLY is called only if COMPUTE returns a geometry different from the last applied one
+  void add_layout(std::function<geometry(size)> COMPUTE, std::function<void(const geometry&)> APPLY)
+  {
+    layouts.push_back({ std::move(COMPUTE), std::move(APPLY), std::nullopt });
+  }
+
+  /*
+   * Keeps the window opened with window(GRID, TITLE) centered, the windows have to
+   * be the topmost ones and added in the same order they were opened. Moving a window
+   * reopens it and the ones above it blank, the owner form is drawn again afterwards
+   */
+  void add_window(const grid& GRID, const c_string_view TITLE = {})
+  {
+    const auto GRID_DATA { static_cast<newtGrid>(GRID) };
+    auto title { (TITLE.c_str() == nullptr) ? std::nullopt : std::optional<std::string> { TITLE.c_str() } };
+    const auto APPLIED { centered(GRID_DATA, title, get_screen_size()) };
+    windows.push_back({ GRID_DATA, std::move(title), APPLIED, nullptr });
+  }
+
+  // Same as above, and SHOWN, the form in the window, is drawn again whenever the window is reopened
+  void add_window(const grid& GRID, form& SHOWN, const c_string_view TITLE = {})
+  {
+    add_window(GRID, TITLE);
+    windows.back().shown = &SHOWN;
+  }
+
+  // Called after the resize settled, can be called directly to force a relayout
+  void relayout()
+  {
+    pending.reset();
+    resize_screen(0);
+
+    const size SCREEN { get_screen_size() };
+    for (auto& [COMPUTE, APPLY, APPLIED] : layouts) {
+      const auto GEOMETRY { COMPUTE(SCREEN) };
+      if (GEOMETRY != APPLIED) {
+        APPLY(GEOMETRY);
+        APPLIED = GEOMETRY;
+      }
+    }
+
+    relayout_windows(SCREEN);
+
+    owner.draw_form();
+    refresh();
+  }
+
+  [[nodiscard]] bool is_pending() const
+  {
+    return pending.has_value();
+  }
+};
+
+/*
+ *         FILE VIEWER
+ */
+
+class file_viewer : public component {
+  /*
+   * The file is memory mapped and only the visible page is copied and handed to newt.
+   * A background thread records where every LINES_PER_CHECKPOINT-th line starts, so the
+   * index takes 8 bytes every LINES_PER_CHECKPOINT lines and any line is at most that many
+   * lines away from a known offset. The lines longer than LONG_LINE are recorded too, so
+   * drawing and scrolling never scan more than that for a line end. The state lives on
+   * the heap since the indexer and the hot keys keep a pointer to it, and it must survive
+   * moves of the viewer.
+   */
+  static constexpr size_t LINES_PER_CHECKPOINT { 1024 };
+  static constexpr size_t LONG_LINE { 4096 };
+  static constexpr size_t RENDER_SCAN { 16U << 20U }; // bytes a page can scan for the ends of long lines not indexed yet
+  static constexpr size_t UNKNOWN { std::string_view::npos };
+
+  struct state {
+    newtComponent textbox;
+    int width;
+    int height;
+
+    const char* map { nullptr }; // null if the file couldn't be mapped or is empty
+    size_t map_size { 0 };
+    std::error_code error;
+
+    mutable std::mutex index_mutex;
+    std::vector<size_t> checkpoints { 0 };
+    std::vector<std::pair<size_t, size_t>> long_lines; // start and end, the '\n' or map_size
+    std::atomic<size_t> indexed_lines { 0 };
+    std::atomic<bool> indexed { false };
+
+    size_t top_offset { 0 };
+    size_t top_line { 0 };
+    std::string screen;
+
+    std::jthread indexer;
+
+    state(newtComponent TEXTBOX, const size SIZE, const char* const PATH)
+        : textbox(TEXTBOX)
+        , width(SIZE.width)
+        , height(std::max(SIZE.height, 1))
+    {
+      const int FILE_DESCRIPTOR { open(PATH, O_RDONLY | O_CLOEXEC) }; // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-signed-bitwise)
+      if (FILE_DESCRIPTOR == -1) {
+        error = std::error_code { errno, std::generic_category() };
+        indexed = true;
+        return;
+      }
+
+      struct stat info { };
+      if (fstat(FILE_DESCRIPTOR, &info) != 0) {
+        error = std::error_code { errno, std::generic_category() };
+      } else if (info.st_size > 0) {
+        void* const MAPPED { mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, FILE_DESCRIPTOR, 0) };
+        if (MAPPED == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+          error = std::error_code { errno, std::generic_category() };
+        } else {
+          map = static_cast<const char*>(MAPPED);
+          map_size = static_cast<size_t>(info.st_size);
+        }
+      }
+      close(FILE_DESCRIPTOR);
+
+      if (map == nullptr) {
+        indexed = true;
+        return;
+      }
+
+      indexer = std::jthread { [this](const std::stop_token& STOP) { build_index(STOP); } };
+    }
+
+    state(const state&) = delete;
+    state(state&&) = delete;
+    state& operator=(const state&) = delete;
+    state& operator=(state&&) = delete;
+
+    ~state()
+    {
+      // The indexer reads the map, it has to stop before unmapping
+      indexer.request_stop();
+      if (indexer.joinable()) {
+        indexer.join();
+      }
+
+      if (map != nullptr) {
+        munmap(const_cast<char*>(map), map_size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+      }
+    }
+
+    // Checkpoints are published in batches to keep the lock out of the scanning loop
+    void build_index(const std::stop_token& STOP)
+    {
+      std::vector<size_t> batch;
+      std::vector<std::pair<size_t, size_t>> long_batch;
+      size_t offset { 0 };
+      size_t lines { 0 };
+
+      while (offset < map_size and not STOP.stop_requested()) {
+        const auto* const NEW_LINE { static_cast<const char*>(std::memchr(map + offset, '\n', map_size - offset)) };
+        const size_t END { (NEW_LINE == nullptr) ? map_size : static_cast<size_t>(NEW_LINE - map) };
+        if (END - offset >= LONG_LINE) {
+          long_batch.emplace_back(offset, END);
+        }
+        offset = std::min(END + 1, map_size);
+        ++lines;
+
+        if (lines % LINES_PER_CHECKPOINT == 0 and offset < map_size) {
+          batch.push_back(offset);
+        }
+
+        // A long line is published right away, the page drawn before waits for its end
+        if (batch.size() == 64 or not long_batch.empty() or offset == map_size) {
+          const std::scoped_lock LOCK { index_mutex };
+          checkpoints.insert(checkpoints.end(), batch.begin(), batch.end());
+          long_lines.insert(long_lines.end(), long_batch.begin(), long_batch.end());
+          indexed_lines.store(lines, std::memory_order_release);
+          batch.clear();
+          long_batch.clear();
+        }
+      }
+
+      indexed.store(offset == map_size, std::memory_order_release);
+    }
+
+    /*
+     * End of the line starting at START, its '\n' or map_size. At most LONG_LINE bytes are
+     * scanned, the end of a longer line is UNKNOWN until the indexer got past it
+     */
+    [[nodiscard]] size_t line_end(const size_t START) const
+    {
+      const size_t SCANNED { std::min(map_size - START, LONG_LINE) };
+      if (const auto* const NEW_LINE { static_cast<const char*>(std::memchr(map + START, '\n', SCANNED)) }; NEW_LINE != nullptr) {
+        return static_cast<size_t>(NEW_LINE - map);
+      }
+      if (SCANNED == map_size - START) {
+        return map_size;
+      }
+
+      const std::scoped_lock LOCK { index_mutex };
+      const auto LONG { std::lower_bound(long_lines.begin(), long_lines.end(), std::pair { START, size_t { 0 } }) };
+      return (LONG != long_lines.end() and LONG->first == START) ? LONG->second : UNKNOWN;
+    }
+
+    // Start of the line ending with the '\n' at END, UNKNOWN like line_end()
+    [[nodiscard]] size_t line_start(const size_t END) const
+    {
+      const size_t SCANNED { std::min(END, LONG_LINE) };
+      if (const auto* const NEW_LINE { static_cast<const char*>(memrchr(map + END - SCANNED, '\n', SCANNED)) }; NEW_LINE != nullptr) {
+        return static_cast<size_t>(NEW_LINE - map) + 1;
+      }
+      if (SCANNED == END) {
+        return 0;
+      }
+
+      const std::scoped_lock LOCK { index_mutex };
+      const auto LONG { std::lower_bound(long_lines.begin(), long_lines.end(), END, [](const auto& LINE, const size_t VALUE) { return LINE.second < VALUE; }) };
+      return (LONG != long_lines.end() and LONG->second == END) ? LONG->first : UNKNOWN;
+    }
+
+    /*
+     * Returns the start of the line LINES lines after the one starting at OFFSET and how many lines it moved.
+     * Scrolling asks for the lines, a long line not indexed yet is scanned whole
+     */
+    [[nodiscard]] std::pair<size_t, size_t> skip_forward(size_t offset, const size_t LINES) const
+    {
+      size_t moved { 0 };
+      for (; moved < LINES; ++moved) {
+        size_t end { line_end(offset) };
+        if (end == UNKNOWN) {
+          const auto* const NEW_LINE { static_cast<const char*>(std::memchr(map + offset, '\n', map_size - offset)) };
+          end = (NEW_LINE == nullptr) ? map_size : static_cast<size_t>(NEW_LINE - map);
+        }
+        if (end + 1 >= map_size) {
+          break;
+        }
+        offset = end + 1;
+      }
+
+      return { offset, moved };
+    }
+
+    [[nodiscard]] std::pair<size_t, size_t> skip_backward(size_t offset, const size_t LINES) const
+    {
+      size_t moved { 0 };
+      for (; moved < LINES and offset > 0; ++moved) {
+        size_t start { line_start(offset - 1) };
+        if (start == UNKNOWN) {
+          const auto* const NEW_LINE { static_cast<const char*>(memrchr(map, '\n', offset - 1)) };
+          start = (NEW_LINE == nullptr) ? 0 : static_cast<size_t>(NEW_LINE - map) + 1;
+        }
+        offset = start;
+      }
+
+      return { offset, moved };
+    }
+
+    void render()
+    {
+      screen.clear();
+
+      // Only the bytes that can be shown are searched for the line end, with room for a '\r'
+      const size_t VISIBLE_BYTES { static_cast<size_t>(std::max(width, 0)) * 4 + 2 };
+      size_t scan_left { RENDER_SCAN };
+
+      size_t offset { top_offset };
+      for (int row { 0 }; row < height and offset < map_size; ++row) {
+        auto line { std::string_view { map + offset, std::min(map_size - offset, VISIBLE_BYTES) } };
+        if (const auto NEW_LINE { line.find('\n') }; NEW_LINE != std::string_view::npos) {
+          line = line.substr(0, NEW_LINE);
+          if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+          }
+        }
+
+        const size_t BEGIN { screen.size() };
+        screen += truncate_to_width(line, width);
+        // newt takes a C string, binary files would be cut at the first NUL
+        std::replace(screen.begin() + static_cast<std::ptrdiff_t>(BEGIN), screen.end(), '\0', ' ');
+        screen += '\n';
+
+        size_t end { line_end(offset) };
+        if (end == UNKNOWN and scan_left > 0) {
+          const size_t SCANNED { std::min(map_size - offset, scan_left) };
+          const auto* const NEW_LINE { static_cast<const char*>(std::memchr(map + offset, '\n', SCANNED)) };
+          end = (NEW_LINE != nullptr) ? static_cast<size_t>(NEW_LINE - map) : ((SCANNED == map_size - offset) ? map_size : UNKNOWN);
+          scan_left -= SCANNED;
+        }
+
+        // The rows after a huge line that isn't indexed yet are drawn by a later render
+        if (end == UNKNOWN) {
+          break;
+        }
+        offset = end + 1;
+      }
+
+      if (not screen.empty()) {
+        screen.pop_back();
+      }
+
+      NEWTPP_CALL(newtTextboxSetText)(textbox, screen.c_str());
+    }
+
+    void move_to(const size_t OFFSET, const size_t LINE)
+    {
+      top_offset = OFFSET;
+      top_line = LINE;
+      render();
+    }
+
+    void scroll(const long long LINES)
+    {
+      // Without a mapping there is nothing to scan, memchr and memrchr can't take a null pointer
+      if (map == nullptr) {
+        return;
+      }
+
+      if (LINES >= 0) {
+        const auto [OFFSET, MOVED] = skip_forward(top_offset, static_cast<size_t>(LINES));
+        move_to(OFFSET, top_line + MOVED);
+      } else {
+        const auto [OFFSET, MOVED] = skip_backward(top_offset, static_cast<size_t>(-LINES));
+        move_to(OFFSET, top_line - MOVED);
+      }
+    }
+
+    // Lines past the indexed part of the file are clamped to the last indexed checkpoint
+    void goto_line(const size_t LINE)
+    {
+      if (map == nullptr) {
+        return;
+      }
+
+      size_t checkpoint { 0 };
+      size_t offset { 0 };
+      {
+        const std::scoped_lock LOCK { index_mutex };
+        checkpoint = std::min(LINE / LINES_PER_CHECKPOINT, checkpoints.size() - 1);
+        offset = checkpoints[checkpoint];
+      }
+
+      const auto [OFFSET, MOVED] = skip_forward(offset, LINE - std::min(LINE, checkpoint * LINES_PER_CHECKPOINT));
+      move_to(OFFSET, checkpoint * LINES_PER_CHECKPOINT + MOVED);
+    }
+
+    void show_offset(const size_t OFFSET)
+    {
+      if (map == nullptr) {
+        return;
+      }
+
+      const size_t TARGET { std::min(OFFSET, map_size - 1) };
+      size_t checkpoint { 0 };
+      size_t offset { 0 };
+      {
+        const std::scoped_lock LOCK { index_mutex };
+        const auto NEXT { std::upper_bound(checkpoints.begin(), checkpoints.end(), TARGET) };
+        checkpoint = static_cast<size_t>(std::distance(checkpoints.begin(), NEXT)) - 1;
+        offset = checkpoints[checkpoint];
+      }
+
+      const auto LINES { static_cast<size_t>(std::count(map + offset, map + TARGET, '\n')) };
+      const auto* const NEW_LINE { static_cast<const char*>(memrchr(map, '\n', TARGET)) };
+      move_to((NEW_LINE == nullptr) ? 0 : static_cast<size_t>(NEW_LINE - map) + 1, checkpoint * LINES_PER_CHECKPOINT + LINES);
+    }
+  };
+
+  std::unique_ptr<state> view;
+
+  public:
+  // The first page is shown right away, the index is built while the user looks at it
+  file_viewer(const size SIZE, const c_string_view PATH, const position POS = { 0, 0 }) noexcept
+      : component(NEWTPP_CALL(newtTextbox)(POS.left, POS.top, SIZE.width, SIZE.height, 0))
+      , view(std::make_unique<state>(*data, SIZE, PATH.c_str()))
+  {
+    view->render();
+  }
+
+  // An empty file is open, but there is nothing to show
+  [[nodiscard]] bool is_open() const
+  {
+    return not view->error;
+  }
+
+  // Why the file couldn't be opened or mapped, empty if is_open()
+  [[nodiscard]] std::error_code get_error() const
+  {
+    return view->error;
+  }
+
+  // The whole file, valid as long as the viewer lives
+  [[nodiscard]] std::string_view text() const
+  {
+    return { view->map, view->map_size };
+  }
+
+  void scroll(const long long LINES)
+  {
+    view->scroll(LINES);
+  }
+
+  void page_down()
+  {
+    view->scroll(view->height);
+  }
+
+  void page_up()
+  {
+    view->scroll(-view->height);
+  }
+
+  void goto_line(const size_t LINE)
+  {
+    view->goto_line(LINE);
+  }
+
+  // Scrolls to the line that contains the byte at OFFSET
+  void show_offset(const size_t OFFSET)
+  {
+    view->show_offset(OFFSET);
+  }
+
+  [[nodiscard]] size_t get_top_line() const
+  {
+    return view->top_line;
+  }
+
+  [[nodiscard]] size_t get_top_offset() const
+  {
+    return view->top_offset;
+  }
+
+  // Lines indexed so far, it's the number of lines of the file once is_indexed() is true
+  [[nodiscard]] size_t get_num_lines() const
+  {
+    return view->indexed_lines.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] bool is_indexed() const
+  {
+    return view->indexed.load(std::memory_order_acquire);
+  }
+
+  // Scrolls the viewer with the arrows, page up/down, home and end while FORM runs
+  void bind(form& FORM)
+  {
+    state* const VIEW { view.get() };
+    FORM.add_repeat_key(NEWT_KEY_UP, [VIEW](const int STEPS) { VIEW->scroll(-STEPS); }, true);
+    FORM.add_repeat_key(NEWT_KEY_DOWN, [VIEW](const int STEPS) { VIEW->scroll(STEPS); }, true);
+    FORM.add_repeat_key(NEWT_KEY_PGUP, [VIEW](const int STEPS) { VIEW->scroll(-static_cast<long long>(STEPS) * VIEW->height); });
+    FORM.add_repeat_key(NEWT_KEY_PGDN, [VIEW](const int STEPS) { VIEW->scroll(static_cast<long long>(STEPS) * VIEW->height); });
+    FORM.add_hot_key(NEWT_KEY_HOME, [VIEW]() { VIEW->move_to(0, 0); return true; });
+    FORM.add_hot_key(NEWT_KEY_END, [VIEW]() {
+      VIEW->goto_line(VIEW->indexed_lines.load(std::memory_order_acquire));
+      VIEW->scroll(-(VIEW->height - 1));
+      return true;
+    });
+  }
+};
+
+/*
+ *         INCREMENTAL SEARCH
+ */
+
+/*
+ * Calls ON_CHANGE with the value of ENTRY every time it changes. newt keeps the callback
+ * of a component until it's destroyed, and the form owning the entry can destroy it
+ * before or after the watch. So newt only gets a static callback that looks the entry up
+ * here: a watch that goes away unregisters without touching the entry, and an entry
+ * that was destroyed never calls back. Only one watch per entry, the last one wins
+ */
+class entry_watch {
+  static inline std::unordered_map<newtComponent, entry_watch*> watches;
+
+  newtComponent entry;
+  std::function<void(std::string_view)> on_change;
+
+  static void changed(newtComponent ENTRY, void* /*unused*/)
+  {
+    const auto FOUND { watches.find(ENTRY) };
+    if (FOUND != watches.end()) {
+      FOUND->second->notify();
+    }
+  }
+
+  public:
+  entry_watch(entrybox& ENTRY, std::function<void(std::string_view)> ON_CHANGE)
+      : entry(*ENTRY)
+      , on_change(std::move(ON_CHANGE))
+  {
+    watches.insert_or_assign(entry, this);
+    NEWTPP_CALL(newtComponentAddCallback)(entry, changed, nullptr);
+  }
+
+  entry_watch(const entry_watch&) = delete;
+  entry_watch(entry_watch&&) = delete;
+  entry_watch& operator=(const entry_watch&) = delete;
+  entry_watch& operator=(entry_watch&&) = delete;
+
+  ~entry_watch()
+  {
+    // The address may belong to a newer entry by now, only our own registration is removed
+    const auto FOUND { watches.find(entry) };
+    if (FOUND != watches.end() and FOUND->second == this) {
+      watches.erase(FOUND);
+    }
+  }
+
+  // Calls ON_CHANGE with the current value, the entry must still exist
+  void notify()
+  {
+    const char* const VALUE { NEWTPP_CALL(newtEntryGetValue)(entry) };
+    on_change((VALUE == nullptr) ? std::string_view {} : std::string_view { VALUE });
+  }
+
+  [[nodiscard]] newtComponent get_entry() const
+  {
+    return entry;
+  }
+};
+
+class incremental_search {
+  /*
+   * Searches as the entry changes. While the query only grows the next match can't
+   * be before the current one, so the search restarts from there instead of from the origin
+   */
+  struct state {
+    std::function<std::string_view()> text;
+    std::function<void(size_t)> show;
+    std::function<size_t()> origin;
+    std::string query;
+    size_t anchor { 0 };
+    size_t match { std::string_view::npos };
+
+    // Searches from FROM to the end, and then wraps around
+    size_t find(const size_t FROM) const
+    {
+      const auto TEXT { text() };
+      const auto FOUND { find_substring(TEXT, query, FROM) };
+      return (FOUND != std::string_view::npos or FROM == 0) ? FOUND : find_substring(TEXT, query, 0);
+    }
+
+    void update(const std::string_view QUERY)
+    {
+      if (QUERY == query) {
+        return;
+      }
+
+      if (QUERY.empty()) {
+        query.clear();
+        match = std::string_view::npos;
+        return;
+      }
+
+      if (query.empty()) {
+        anchor = origin ? origin() : 0;
+      }
+
+      const bool EXTENDED { match != std::string_view::npos and QUERY.starts_with(query) };
+      query = QUERY;
+      match = find(EXTENDED ? match : anchor);
+      if (match != std::string_view::npos) {
+        show(match);
+      }
+    }
+  };
+
+  state search;
+  entry_watch input;
+
+  public:
+  /*
+   * TEXT returns the text to search and SHOW scrolls the view to a match offset,
+   * the search starts from the offset returned by ORIGIN when the entry stops being empty
+   */
+  incremental_search(entrybox& INPUT, std::function<std::string_view()> TEXT, std::function<void(size_t)> SHOW, std::function<size_t()> ORIGIN = nullptr)
+      : search { .text = std::move(TEXT), .show = std::move(SHOW), .origin = std::move(ORIGIN), .query = {} }
+      , input(INPUT, [this](const std::string_view QUERY) { search.update(QUERY); })
+  {
+  }
+
+  // Searches from the top of the viewer, VIEWER must not be moved while the search is alive
+  incremental_search(entrybox& INPUT, file_viewer& VIEWER)
+      : incremental_search(
+          INPUT,
+          [&VIEWER]() { return VIEWER.text(); },
+          [&VIEWER](const size_t OFFSET) { VIEWER.show_offset(OFFSET); },
+          [&VIEWER]() { return VIEWER.get_top_offset(); })
+  {
+  }
+
+  incremental_search(const incremental_search&) = delete;
+  incremental_search(incremental_search&&) = delete;
+  incremental_search& operator=(const incremental_search&) = delete;
+  incremental_search& operator=(incremental_search&&) = delete;
+  ~incremental_search() = default;
+
+  // Searches again for the current value of the entry, for text changed by set_value()
+  void update()
+  {
+    input.notify();
+  }
+
+  // Moves to the match after the current one, wrapping around, and returns its offset
+  size_t next()
+  {
+    if (search.query.empty() or search.match == std::string_view::npos) {
+      return std::string_view::npos;
+    }
+
+    search.match = search.find(search.match + 1);
+    if (search.match != std::string_view::npos) {
+      search.show(search.match);
+    }
+
+    return search.match;
+  }
+
+  // Offset of the current match, npos if the query isn't found
+  [[nodiscard]] size_t get_match() const
+  {
+    return search.match;
+  }
+
+  [[nodiscard]] const std::string& get_query() const
+  {
+    return search.query;
+  }
+
+  // Enter on the entry moves to the next match instead of exiting FORM
+  void bind(form& FORM)
+  {
+    FORM.add_handler(component { input.get_entry(), ownership::BORROWED }, [this]() {
+      next();
+      return true;
+    });
+  }
+};
+
+/*
+ *         TABLE
+ */
+
+template <typename T>
+concept table_value = std::same_as<T, long long> or std::same_as<T, double> or std::same_as<T, std::string>;
+
+/*
+ * A value shared with a background thread that only reads it. Changing it while it's
+ * shared makes a private copy first, so sharing costs a reference and not a copy
+ */
+template <typename value>
+class copy_on_write {
+  std::shared_ptr<value> data;
+
+  public:
+  copy_on_write()
+      : data(std::make_shared<value>())
+  {
+  }
+
+  explicit copy_on_write(value VALUE)
+      : data(std::make_shared<value>(std::move(VALUE)))
+  {
+  }
+
+  const value& operator*() const
+  {
+    return *data;
+  }
+
+  const value* operator->() const
+  {
+    return data.get();
+  }
+
+  value& write()
+  {
+    if (data.use_count() > 1) {
+      data = std::make_shared<value>(*data);
+    }
+    return *data;
+  }
+
+  // use_count() is only exact if the shared copies are released on the thread calling write()
+  [[nodiscard]] std::shared_ptr<const value> share() const
+  {
+    return data;
+  }
+};
+
+/*
+ * Columns are stored as one vector per column, rows are never moved:
+ * the displayed order is a permutation of the row indexes
+ */
+class table_columns : public listbox_source {
+  protected:
+  using column_data = std::variant<std::vector<long long>, std::vector<double>, std::vector<std::string>>;
+
+  struct column {
+    std::string title;
+    int width;
+    int precision; // digits after the point of double columns
+    copy_on_write<column_data> values;
+  };
+
+  std::vector<column> columns;
+  copy_on_write<std::vector<std::uint32_t>> order;
+
+  // Every code point takes a column, the cell is cut at WIDTH columns and padded up to it
+  static void append_cell(std::string& line, const std::string_view TEXT, const int WIDTH, const bool RIGHT_ALIGNED)
+  {
+    const auto COLUMNS { static_cast<size_t>(std::max(WIDTH, 0)) };
+    size_t length { 0 };
+    size_t used { 0 };
+    for (; length < TEXT.size(); ++length) {
+      if ((static_cast<unsigned char>(TEXT[length]) & 0xC0U) != 0x80U) {
+        if (used == COLUMNS) {
+          break;
+        }
+        ++used;
+      }
+    }
+
+    const auto CELL { TEXT.substr(0, length) };
+    const auto PADDING { COLUMNS - used };
+
+    if (RIGHT_ALIGNED) {
+      line.append(PADDING, ' ');
+    }
+    line += CELL;
+    if (not RIGHT_ALIGNED) {
+      line.append(PADDING, ' ');
+    }
+  }
+
+  public:
+  [[nodiscard]] size_t count() const override
+  {
+    return order->size();
+  }
+
+  [[nodiscard]] std::string row(const size_t INDEX) const override
+  {
+    const auto ROW { (*order)[INDEX] };
+    std::string line;
+
+    for (const auto& [TITLE, WIDTH, PRECISION, VALUES] : columns) {
+      if (not line.empty()) {
+        line += ' ';
+      }
+
+      std::visit(
+          [&]<typename values>(const values& COLUMN) {
+            std::array<char, 64> buffer {};
+            if constexpr (std::same_as<values, std::vector<std::string>>) {
+              append_cell(line, COLUMN[ROW], WIDTH, false);
+            } else if constexpr (std::same_as<values, std::vector<double>>) {
+              const auto [END, ERROR] = std::to_chars(buffer.begin(), buffer.end(), COLUMN[ROW], std::chars_format::fixed, PRECISION);
+              append_cell(line, std::string_view { buffer.begin(), (ERROR == std::errc {}) ? END : buffer.begin() }, WIDTH, true);
+            } else {
+              const auto [END, ERROR] = std::to_chars(buffer.begin(), buffer.end(), COLUMN[ROW]);
+              append_cell(line, std::string_view { buffer.begin(), END }, WIDTH, true);
+            }
+          },
+          *VALUES);
+    }
+
+    return line;
+  }
+};
+
+class table : private table_columns, public listbox {
+  label header;
+  command_queue completions;
+
+  // Only one sort runs at a time, the last one asked while running is started when it ends
+  std::optional<std::pair<size_t, bool>> queued_sort;
+  bool sorting { false };
+  std::jthread sorter;
+
+  template <typename value>
+  static void parallel_sort(std::vector<std::uint32_t>& ORDER, const std::vector<value>& KEYS, const bool ASCENDING)
+  {
+    const auto LESS { [&](const std::uint32_t LEFT, const std::uint32_t RIGHT) {
+      // NaN compares false with everything, it would break the ordering: it goes last either way
+      if constexpr (std::floating_point<value>) {
+        const bool LEFT_NAN { std::isnan(KEYS[LEFT]) };
+        const bool RIGHT_NAN { std::isnan(KEYS[RIGHT]) };
+        if (LEFT_NAN or RIGHT_NAN) {
+          return not LEFT_NAN;
+        }
+      }
+      return ASCENDING ? KEYS[LEFT] < KEYS[RIGHT] : KEYS[RIGHT] < KEYS[LEFT];
+    } };
+
+    // Stable chunks merged stably keep the previous order of equal keys
+    constexpr size_t MIN_CHUNK { 1U << 16U };
+    const size_t CHUNKS { std::clamp<size_t>(ORDER.size() / MIN_CHUNK, 1, std::max(std::thread::hardware_concurrency(), 1U)) };
+
+    std::vector<size_t> bounds(CHUNKS + 1);
+    for (size_t chunk { 0 }; chunk <= CHUNKS; ++chunk) {
+      bounds[chunk] = ORDER.size() * chunk / CHUNKS;
+    }
+
+    const auto AT { [&](const size_t BOUND) { return ORDER.begin() + static_cast<std::ptrdiff_t>(bounds[std::min(BOUND, CHUNKS)]); } };
+
+    {
+      std::vector<std::jthread> workers;
+      for (size_t chunk { 1 }; chunk < CHUNKS; ++chunk) {
+        workers.emplace_back([&, chunk]() { std::stable_sort(AT(chunk), AT(chunk + 1), LESS); });
+      }
+      std::stable_sort(AT(0), AT(1), LESS);
+    }
+
+    for (size_t width { 1 }; width < CHUNKS; width *= 2) {
+      std::vector<std::jthread> workers;
+      for (size_t chunk { 0 }; chunk + width < CHUNKS; chunk += 2 * width) {
+        workers.emplace_back([&, chunk, width]() { std::inplace_merge(AT(chunk), AT(chunk + width), AT(chunk + 2 * width), LESS); });
+      }
+    }
+  }
+
+  void start_sort(const size_t COLUMN, const bool ASCENDING)
+  {
+    sorting = true;
+
+    /*
+     * The worker gets the order and the keys shared, rows added meanwhile copy them first.
+     * The shared references go back with the result, so they are released on this thread
+     */
+    sorter = std::jthread { [this, ORDER = order.share(), KEYS = columns[COLUMN].values.share(), ASCENDING]() mutable {
+      std::vector<std::uint32_t> sorted { *ORDER };
+      std::visit([&](const auto& VALUES) { parallel_sort(sorted, VALUES, ASCENDING); }, *KEYS);
+      completions.post([this, SORTED = std::move(sorted), ORDER = std::move(ORDER), KEYS = std::move(KEYS)]() mutable { finish_sort(std::move(SORTED)); });
+    } };
+  }
+
+  void finish_sort(std::vector<std::uint32_t> SORTED)
+  {
+    // Rows added while sorting go at the bottom
+    for (auto row { static_cast<std::uint32_t>(SORTED.size()) }; row < order->size(); ++row) {
+      SORTED.push_back(row);
+    }
+    order = copy_on_write { std::move(SORTED) };
+    sorting = false;
+    reload();
+
+    if (queued_sort) {
+      const auto [COLUMN, ASCENDING] = *queued_sort;
+      queued_sort.reset();
+      start_sort(COLUMN, ASCENDING);
+    }
+  }
+
+  // Values that don't fit the type of the column are left empty
+  template <typename cell>
+  static void push_cell(copy_on_write<column_data>& COLUMN, cell&& CELL)
+  {
+    std::visit(
+        [&]<typename stored>(std::vector<stored>& VALUES) {
+          if constexpr (std::is_constructible_v<stored, cell&&>) {
+            VALUES.emplace_back(std::forward<cell>(CELL));
+          } else {
+            VALUES.emplace_back();
+          }
+        },
+        COLUMN.write());
+  }
+
+  void update_header()
+  {
+    std::string line;
+    for (const auto& [TITLE, WIDTH, PRECISION, VALUES] : columns) {
+      if (not line.empty()) {
+        line += ' ';
+      }
+      append_cell(line, TITLE, WIDTH, not std::holds_alternative<std::vector<std::string>>(*VALUES));
+    }
+    header.set_text(line);
+  }
+
+  public:
+  // The header goes on POS, the rows in the HEIGHT - 1 lines below it
+  explicit table(const int HEIGHT, const position POS = { 0, 0 }) noexcept
+      : listbox(std::max(HEIGHT - 1, 1), *this, { POS.left, POS.top + 1 })
+      , header(" ", POS)
+  {
+  }
+
+  table(const table&) = delete;
+  table(table&&) = delete;
+  table& operator=(const table&) = delete;
+  table& operator=(table&&) = delete;
+  ~table() = default;
+
+  // Sorts end on the thread running FORM
+  void attach(form& FORM)
+  {
+    completions.attach(FORM);
+  }
+
+  label& get_header()
+  {
+    return header;
+  }
+
+  // PRECISION is the number of digits shown after the point by double columns
+  template <table_value value>
+  size_t add_column(std::string TITLE, const int WIDTH, const int PRECISION = 2)
+  {
+    columns.push_back({ std::move(TITLE), WIDTH, PRECISION, copy_on_write<column_data> { std::vector<value>(order->size()) } });
+    update_header();
+    return columns.size() - 1;
+  }
+
+  void reserve(const size_t ROWS)
+  {
+    order.write().reserve(ROWS);
+    for (auto& COLUMN : columns) {
+      std::visit([&](auto& VALUES) { VALUES.reserve(ROWS); }, COLUMN.values.write());
+    }
+  }
+
+  // Takes a value for each column, the rows are shown after reload()
+  template <typename... cells>
+  void add_row(cells&&... CELLS)
+  {
+    size_t index { 0 };
+    (((index < columns.size()) ? push_cell(columns[index++].values, std::forward<cells>(CELLS)) : void()), ...);
+
+    // Missing values are left empty
+    for (; index < columns.size(); ++index) {
+      std::visit([](auto& COLUMN) { COLUMN.emplace_back(); }, columns[index].values.write());
+    }
+
+    auto& rows { order.write() };
+    rows.push_back(static_cast<std::uint32_t>(rows.size()));
+  }
+
+  [[nodiscard]] size_t get_num_rows() const
+  {
+    return order->size();
+  }
+
+  // Row index, in insertion order, of the row displayed at POSITION
+  [[nodiscard]] size_t get_row(const size_t POSITION) const
+  {
+    return (*order)[POSITION];
+  }
+
+  template <table_value value>
+  [[nodiscard]] const value& get_value(const size_t ROW, const size_t COLUMN) const
+  {
+    return std::get<std::vector<value>>(*columns[COLUMN].values)[ROW];
+  }
+
+  /*
+   * Sorts on a background thread and shows the new order once done, equal values keep the
+   * order they had before so sorting by a column and then by another sorts by both
+   */
+  void sort_by(const size_t COLUMN, const bool ASCENDING = true)
+  {
+    if (COLUMN >= columns.size()) {
+      return;
+    }
+
+    if (sorting) {
+      queued_sort.emplace(COLUMN, ASCENDING);
+      return;
+    }
+
+    start_sort(COLUMN, ASCENDING);
+  }
+
+  [[nodiscard]] bool is_sorting() const
+  {
+    return sorting;
   }
 };
 
-template <component_range... ranges>
-[[nodiscard]] inline std::pair<exit_info, form> fast_run(const int COLS, const int ROWS, const std::string_view TITLE, ranges&... components)
-{
-  const grid GRID { COLS, ROWS, components... };
-  const window WINDOW { GRID, TITLE };
-  form user_form { components... };
+/*
+ *         PROGRESS
+ */
 
-  return { user_form.run(), std::move(user_form) };
-}
+// Own cache line, so sources updated by different threads don't slow down each other
+class alignas(64) progress_source {
+  std::atomic<unsigned long long> value { 0 };
 
-class button : public component {
   public:
-  explicit button(const std::string_view TEXT, const position POS = { 0, 0 }) noexcept
-      : component(newtButton(POS.left, POS.top, TEXT.data()))
+  // Safe to call from any thread, it never blocks nor calls newt
+  void add(const unsigned long long AMOUNT = 1)
   {
+    value.fetch_add(AMOUNT, std::memory_order_relaxed);
   }
-};
 
-class compact_button : public component {
-  public:
-  explicit compact_button(const std::string_view TEXT, const position POS = { 0, 0 }) noexcept
-      : component(newtCompactButton(POS.left, POS.top, TEXT.data()))
+  void set(const unsigned long long VALUE)
   {
+    value.store(VALUE, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] unsigned long long get() const
+  {
+    return value.load(std::memory_order_relaxed);
   }
 };
 
-class label : public component {
+class progress_sampler {
+  struct binding {
+    newtComponent scale;
+    const progress_source* source;
+    unsigned long long width;
+    unsigned long long full_value;
+    std::uint64_t rendered;
+  };
+
+  form& owner;
+  timer_wheel::timer_id timer;
+  std::vector<binding> bindings;
+
+  // The filled cells and the percentage shown, computed as newtScaleSet does
+  static std::uint64_t rendered_state(const binding& BINDING, const unsigned long long VALUE)
+  {
+    const auto& [SCALE, SOURCE, WIDTH, FULL_VALUE, RENDERED] = BINDING;
+    if (WIDTH == 0 or FULL_VALUE == 0 or VALUE >= FULL_VALUE) {
+      return (WIDTH << 8U) | 100U;
+    }
+
+    // Large values are divided first to avoid overflowing
+    if (FULL_VALUE >= ~0ULL / std::max(100ULL, WIDTH)) {
+      return ((VALUE / (FULL_VALUE / WIDTH)) << 8U) | (VALUE / (FULL_VALUE / 100));
+    }
+
+    return (((VALUE * WIDTH) / FULL_VALUE) << 8U) | ((VALUE * 100) / FULL_VALUE);
+  }
+
   public:
-  explicit label(const std::string_view TEXT, const position POS = { 0, 0 }) noexcept
-      : component(newtLabel(POS.left, POS.top, TEXT.data()))
+  // Samples the sources every PERIOD while FORM runs, FORM must outlive the sampler
+  explicit progress_sampler(form& FORM, const std::chrono::milliseconds PERIOD = std::chrono::milliseconds { 50 })
+      : owner(FORM)
+      , timer(FORM.add_timer(PERIOD, [this]() { sample(); }))
   {
   }
 
-  void set_text(const std::string_view TEXT)
+  progress_sampler(const progress_sampler&) = delete;
+  progress_sampler(progress_sampler&&) = delete;
+  progress_sampler& operator=(const progress_sampler&) = delete;
+  progress_sampler& operator=(progress_sampler&&) = delete;
+
+  ~progress_sampler()
   {
-    newtLabelSetText(*data, TEXT.data());
+    owner.cancel_timer(timer);
   }
 
-  void set_colors(const int COLOR_SET)
+  // SOURCE must outlive the sampler
+  void add(const scale& SCALE, const progress_source& SOURCE)
+  {
+    const auto FULL_VALUE { static_cast<unsigned long long>(std::max(SCALE.get_full_value(), 0LL)) };
+    bindings.push_back({ *SCALE, &SOURCE, static_cast<unsigned long long>(std::max(SCALE.get_width(), 0)), FULL_VALUE, ~std::uint64_t { 0 } });
+  }
+
+  void remove(const scale& SCALE)
   {
-    newtLabelSetColors(*data, COLOR_SET);
+    std::erase_if(bindings, [&](const binding& BINDING) { return BINDING.scale == *SCALE; });
+  }
+
+  // Updates the scales whose fill changed since the last sample and returns how many
+  size_t sample()
+  {
+    size_t updated { 0 };
+    for (auto& BINDING : bindings) {
+      const auto VALUE { BINDING.source->get() };
+      const auto STATE { rendered_state(BINDING, VALUE) };
+      if (STATE == BINDING.rendered) {
+        continue;
+      }
+
+      BINDING.rendered = STATE;
+      NEWTPP_CALL(newtScaleSet)(BINDING.scale, VALUE);
+      ++updated;
+    }
+
+    return updated;
   }
 };
 
-class entrybox : public component {
-  const char* content;
+/*
+ *         CHECKBOX TREE
+ */
+
+struct tree_node {
+  std::string text;
+  std::uint64_t key { 0 }; // passed to the loader when the node is expanded
+  bool has_children { false };
+};
 
+/*
+ * Nodes are numbered in load order and the children of a node are loaded all
+ * together, so they are the consecutive ids [first_child, first_child + num_children).
+ * Only the nodes of the expanded subtrees are in visible.
+ */
+class tree_nodes : public listbox_source {
   public:
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init, hicpp-member-init, hicpp-signed-bitwise) -- content gets initted by newtEntry
-  explicit entrybox(const int WIDTH, const position POS = { 0, 0 }, std::string_view INITIAL_VALUE = { "" }, const int FLAGS = NEWT_ENTRY_SCROLL) noexcept
-      : component(newtEntry(POS.left, POS.top, INITIAL_VALUE.data(), WIDTH, &content, FLAGS))
+  using node_id = std::uint32_t;
+  using children_loader = std::function<std::vector<tree_node>(std::uint64_t)>;
+
+  static constexpr node_id NO_PARENT { ~node_id { 0 } };
+
+  protected:
+  static constexpr node_id HIDDEN { ~node_id { 0 } }; // position of the nodes that aren't visible
+
+  struct node {
+    std::string text;
+    std::uint64_t key;
+    node_id parent;
+    node_id first_child { 0 };
+    node_id num_children { 0 };
+    std::uint16_t depth;
+    bool has_children;
+    bool loaded { false };
+    bool expanded { false };
+  };
+
+  children_loader loader;
+  std::vector<node> nodes;
+  std::vector<node_id> visible;
+  std::vector<node_id> positions; // position in visible of each node id, or HIDDEN
+  std::vector<std::uint64_t> checked; // a bit for each node id
+
+  node_id load(const node_id PARENT, const std::uint64_t KEY)
+  {
+    auto children { loader(KEY) };
+    const auto FIRST { static_cast<node_id>(nodes.size()) };
+    const auto DEPTH { static_cast<std::uint16_t>((PARENT == NO_PARENT) ? 0 : nodes[PARENT].depth + 1) };
+
+    nodes.reserve(nodes.size() + children.size());
+    for (auto& [TEXT, CHILD_KEY, HAS_CHILDREN] : children) {
+      nodes.push_back({ .text = std::move(TEXT), .key = CHILD_KEY, .parent = PARENT, .depth = DEPTH, .has_children = HAS_CHILDREN });
+    }
+    positions.resize(nodes.size(), HIDDEN);
+    checked.resize((nodes.size() + 63) / 64);
+
+    return FIRST;
+  }
+
+  // The rows from FROM on moved, the insertion or the removal shifted them already
+  void renumber(const size_t FROM)
   {
+    for (size_t position { FROM }; position < visible.size(); ++position) {
+      positions[visible[position]] = static_cast<node_id>(position);
+    }
   }
 
-  void set_value(const std::string_view TEXT, const bool CURSOR_AT_END = true)
+  // Appends the visible descendants of ID, in display order
+  void append_visible(const node_id ID, std::vector<node_id>& rows) const
   {
-    newtEntrySet(*data, TEXT.data(), static_cast<int>(CURSOR_AT_END));
+    const auto& NODE { nodes[ID] };
+    for (node_id child { NODE.first_child }; child < NODE.first_child + NODE.num_children; ++child) {
+      rows.push_back(child);
+      if (nodes[child].expanded) {
+        append_visible(child, rows);
+      }
+    }
   }
 
-  std::string_view get_value()
+  [[nodiscard]] size_t subtree_end(const size_t POSITION) const
   {
-    return std::string_view { content };
+    const auto DEPTH { nodes[visible[POSITION]].depth };
+    size_t end { POSITION + 1 };
+    while (end < visible.size() and nodes[visible[end]].depth > DEPTH) {
+      ++end;
+    }
+    return end;
   }
 
-  /* TODO: Add filter api  <29-03-23, Giuseppe> */
-};
+  bool expand_at(const size_t POSITION)
+  {
+    const auto ID { visible[POSITION] };
+    auto& expanding { nodes[ID] };
+    if (expanding.expanded or not expanding.has_children) {
+      return false;
+    }
 
-class checkbox : public component {
-  public:
-  explicit checkbox(const std::string_view TEXT, const position POS = { 0, 0 }, const char DEFAULT_VAL = ' ', const std::string_view SEQ = std::string_view {}) noexcept
-      : component(newtCheckbox(POS.left, POS.top, TEXT.data(), DEFAULT_VAL, SEQ.data(), nullptr))
+    if (not expanding.loaded) {
+      const auto KEY { expanding.key };
+      const auto FIRST { load(ID, KEY) };
+
+      // load() may have moved the nodes
+      auto& loaded { nodes[ID] };
+      loaded.loaded = true;
+      loaded.first_child = FIRST;
+      loaded.num_children = static_cast<node_id>(nodes.size()) - FIRST;
+      loaded.has_children = loaded.num_children != 0;
+      if (not loaded.has_children) {
+        return true;
+      }
+    }
+
+    nodes[ID].expanded = true;
+    std::vector<node_id> rows;
+    append_visible(ID, rows);
+    visible.insert(visible.begin() + static_cast<std::ptrdiff_t>(POSITION + 1), rows.begin(), rows.end());
+    renumber(POSITION + 1);
+    return true;
+  }
+
+  bool collapse_at(const size_t POSITION)
   {
+    auto& collapsing { nodes[visible[POSITION]] };
+    if (not collapsing.expanded) {
+      return false;
+    }
+
+    // The children stay loaded, with their state, for the next expansion
+    collapsing.expanded = false;
+    const auto FIRST { visible.begin() + static_cast<std::ptrdiff_t>(POSITION + 1) };
+    const auto LAST { visible.begin() + static_cast<std::ptrdiff_t>(subtree_end(POSITION)) };
+    for (auto row { FIRST }; row != LAST; ++row) {
+      positions[*row] = HIDDEN;
+    }
+    visible.erase(FIRST, LAST);
+    renumber(POSITION + 1);
+    return true;
   }
 
-  char get_value()
+  [[nodiscard]] bool checked_bit(const node_id ID) const
   {
-    return newtCheckboxGetValue(*data);
+    return ((checked[ID / 64] >> (ID % 64)) & 1U) != 0;
   }
 
-  void set_value(const char VALUE)
+  public:
+  tree_nodes(children_loader LOADER, const std::uint64_t ROOT_KEY)
+      : loader(std::move(LOADER))
   {
-    newtCheckboxSetValue(*data, VALUE);
+    load(NO_PARENT, ROOT_KEY);
+    visible.resize(nodes.size());
+    std::iota(visible.begin(), visible.end(), node_id { 0 });
+    renumber(0);
   }
 
-  /* TODO: add set_flags flags <30-03-23, Giuseppe> */
-};
+  [[nodiscard]] size_t count() const override
+  {
+    return visible.size();
+  }
 
-class radio_button : public component {
-  explicit radio_button(newtComponent other, ptr_type::deleter_ptr deleter_func = newtComponentDestroy)
-      : component(other, deleter_func)
+  [[nodiscard]] std::string row(const size_t INDEX) const override
   {
+    const auto ID { visible[INDEX] };
+    const auto& NODE { nodes[ID] };
+
+    std::string line(2 * static_cast<size_t>(NODE.depth), ' ');
+    line += checked_bit(ID) ? "[*] " : "[ ] ";
+    line += NODE.has_children ? (NODE.expanded ? "- " : "+ ") : "  ";
+    line += NODE.text;
+    return line;
   }
+};
 
+class checkbox_tree : private tree_nodes, public listbox {
   public:
-  radio_button()
-      : component(nullptr, ptr_type::no_delete)
+  using tree_nodes::children_loader;
+  using tree_nodes::NO_PARENT;
+  using tree_nodes::node_id;
+
+  /*
+   * LOADER is called with ROOT_KEY for the top level nodes, and with the key of a node
+   * the first time it is expanded. Only the loaded nodes take memory
+   */
+  checkbox_tree(const int HEIGHT, children_loader LOADER, const std::uint64_t ROOT_KEY = 0, const position POS = { 0, 0 }) noexcept
+      : tree_nodes(std::move(LOADER), ROOT_KEY)
+      , listbox(HEIGHT, *this, POS)
   {
   }
 
-  explicit radio_button(std::string_view TEXT, const position POS = { 0, 0 }, const radio_button& PREVIUS = {}, bool IS_DEFAULT = false) noexcept
-      : component(newtRadiobutton(POS.left, POS.top, TEXT.data(), static_cast<int>(IS_DEFAULT), *PREVIUS))
+  checkbox_tree(const checkbox_tree&) = delete;
+  checkbox_tree(checkbox_tree&&) = delete;
+  checkbox_tree& operator=(const checkbox_tree&) = delete;
+  checkbox_tree& operator=(checkbox_tree&&) = delete;
+  ~checkbox_tree() = default;
+
+  /*
+   * Moves like listbox::bind, space checks the current node, right and + expand it,
+   * left and - collapse it or go to its parent. These are hot keys of the whole form,
+   * newt handles them before the focused component: an entry in the same form can't
+   * get them anymore
+   */
+  void bind(form& FORM)
   {
+    listbox::bind(FORM);
+
+    const auto TOGGLE { [this]() {
+      if (not visible.empty()) {
+        toggle_checked(get_current_node());
+      }
+      return true;
+    } };
+    const auto EXPAND { [this]() {
+      if (not visible.empty() and expand_at(get_current())) {
+        reload();
+      }
+      return true;
+    } };
+    const auto COLLAPSE { [this]() {
+      if (visible.empty()) {
+        return true;
+      }
+
+      const auto POSITION { get_current() };
+      if (collapse_at(POSITION)) {
+        reload();
+      } else if (const auto PARENT { nodes[visible[POSITION]].parent }; PARENT != NO_PARENT) {
+        set_current(position_of(PARENT));
+      }
+      return true;
+    } };
+
+    FORM.add_hot_key(' ', TOGGLE);
+    FORM.add_hot_key(NEWT_KEY_RIGHT, EXPAND);
+    FORM.add_hot_key('+', EXPAND);
+    FORM.add_hot_key(NEWT_KEY_LEFT, COLLAPSE);
+    FORM.add_hot_key('-', COLLAPSE);
   }
 
-  [[nodiscard]] radio_button get_current() const
+  // The tree must not be empty
+  [[nodiscard]] node_id get_current_node() const
   {
-    return radio_button { newtRadioGetCurrent(*data), ptr_type::no_delete };
+    return visible[get_current()];
   }
 
-  void set_current()
+  // Position of the visible node ID, or the number of visible nodes if it is hidden
+  [[nodiscard]] size_t position_of(const node_id ID) const
   {
-    newtRadioSetCurrent(*data);
+    return (ID < positions.size() and positions[ID] != HIDDEN) ? positions[ID] : visible.size();
   }
-};
 
-class radio_button_collection {
-  std::vector<radio_button> collection {};
+  // Expands ID if it is visible, loading its children the first time
+  void expand(const node_id ID)
+  {
+    if (const auto POSITION { position_of(ID) }; POSITION < visible.size() and expand_at(POSITION)) {
+      reload();
+    }
+  }
 
-  public:
-  template <typename... T>
-  explicit radio_button_collection(T... strings)
+  void collapse(const node_id ID)
   {
-    (add_radio_button(strings), ...);
+    if (const auto POSITION { position_of(ID) }; POSITION < visible.size() and collapse_at(POSITION)) {
+      reload();
+    }
   }
 
-  std::span<component> as_range()
+  [[nodiscard]] bool is_expanded(const node_id ID) const
   {
-    return std::span { reinterpret_cast<component*>(collection.data()), collection.size() };
+    return nodes[ID].expanded;
   }
 
-  [[nodiscard]] std::span<const component> as_range() const
+  // Checking a node doesn't change its children
+  void set_checked(const node_id ID, const bool CHECKED = true)
   {
-    return std::span { reinterpret_cast<const component*>(collection.data()), collection.size() };
+    const auto BIT { std::uint64_t { 1 } << (ID % 64) };
+    checked[ID / 64] = CHECKED ? (checked[ID / 64] | BIT) : (checked[ID / 64] & ~BIT);
+    reload();
   }
 
-  [[nodiscard]] size_t get_current_index() const
+  void toggle_checked(const node_id ID)
   {
-    return static_cast<size_t>(std::abs(std::distance(collection.begin(), std::find(collection.begin(), collection.end(), collection.front().get_current()))));
+    set_checked(ID, not checked_bit(ID));
   }
 
-  void set_current(const size_t INDEX)
+  [[nodiscard]] bool is_checked(const node_id ID) const
   {
-    collection[INDEX].set_current();
+    return checked_bit(ID);
   }
 
-  template <typename... T>
-  void add_radio_button(std::string_view TEXT, const position POS = { 0, 0 }, const bool DEFAULT = false)
+  // Ids of the checked nodes in load order
+  [[nodiscard]] std::vector<node_id> get_checked() const
   {
-    collection.empty()
-        ? collection.emplace_back(TEXT, POS, radio_button {}, DEFAULT)
-        : collection.emplace_back(TEXT, POS, collection.back(), DEFAULT);
+    std::vector<node_id> ids;
+    for (size_t word { 0 }; word < checked.size(); ++word) {
+      for (auto bits { checked[word] }; bits != 0; bits &= bits - 1) {
+        ids.push_back(static_cast<node_id>(word * 64 + static_cast<size_t>(std::countr_zero(bits))));
+      }
+    }
+    return ids;
+  }
+
+  [[nodiscard]] const std::string& get_text(const node_id ID) const
+  {
+    return nodes[ID].text;
+  }
+
+  [[nodiscard]] std::uint64_t get_key(const node_id ID) const
+  {
+    return nodes[ID].key;
+  }
+
+  [[nodiscard]] node_id get_parent(const node_id ID) const
+  {
+    return nodes[ID].parent;
+  }
+
+  [[nodiscard]] size_t get_num_loaded() const
+  {
+    return nodes.size();
   }
 };
 
-class scale : public component {
+/*
+ *         FUZZY PICKER
+ */
+
+/*
+ * The candidates are stored one after the other in a single string, that the matcher
+ * threads scan in order, with a lowercase copy searched by case insensitive queries
+ */
+class fuzzy_results : public listbox_source {
+  protected:
+  std::string text;
+  std::string folded;
+  std::vector<size_t> bounds { 0 }; // candidate i is [bounds[i], bounds[i + 1]) of text
+  std::vector<std::uint32_t> top; // candidates shown, best first
+
+  static char lower(const char CHAR)
+  {
+    return (CHAR >= 'A' and CHAR <= 'Z') ? static_cast<char>(CHAR - 'A' + 'a') : CHAR;
+  }
+
+  [[nodiscard]] size_t num_candidates() const
+  {
+    return bounds.size() - 1;
+  }
+
+  [[nodiscard]] std::string_view candidate(const std::string& TEXT, const size_t INDEX) const
+  {
+    return std::string_view { TEXT }.substr(bounds[INDEX], bounds[INDEX + 1] - bounds[INDEX]);
+  }
+
   public:
-  scale(const int WIDTH, const long long FULL_VALUE, const position POS = { 0, 0 }) noexcept
-      : component(newtScale(POS.left, POS.top, WIDTH, FULL_VALUE))
+  template <std::ranges::input_range range>
+    requires std::convertible_to<std::ranges::range_reference_t<range>, std::string_view>
+  explicit fuzzy_results(range&& CANDIDATES)
+  {
+    if constexpr (std::ranges::sized_range<range>) {
+      bounds.reserve(std::ranges::size(CANDIDATES) + 1);
+    }
+
+    for (auto&& CANDIDATE : CANDIDATES) {
+      text += std::string_view { CANDIDATE };
+      bounds.push_back(text.size());
+    }
+
+    folded.resize(text.size());
+    std::ranges::transform(text, folded.begin(), lower);
+  }
+
+  [[nodiscard]] size_t count() const override
   {
+    return top.size();
   }
 
-  void set_value(const unsigned long long VALUE)
+  [[nodiscard]] std::string row(const size_t INDEX) const override
   {
-    newtScaleSet(*data, VALUE);
+    return std::string { candidate(text, top[INDEX]) };
   }
 };
 
-class textbox : public component {
-  public:
-  explicit textbox(const size SIZE, const std::string_view TEXT, const position POS = { 0, 0 }, const bool IS_SCROLLABLE = true) noexcept
-      // NOLINTNEXTLINE
-      : component(newtTextbox(POS.left, POS.top, SIZE.width, SIZE.height, (IS_SCROLLABLE) ? NEWT_FLAG_SCROLL : 0))
+class fuzzy_picker : private fuzzy_results, public listbox {
+  // The length is kept here so ranking doesn't jump around the text
+  struct match {
+    int score;
+    std::uint32_t length;
+    std::uint32_t index;
+  };
+
+  // The candidates a query matched, in candidate order, all of them when null
+  using match_set = std::shared_ptr<const std::vector<std::uint32_t>>;
+
+  size_t limit;
+  command_queue completions;
+
+  // Only the UI thread touches these, results of older generations are dropped
+  std::uint64_t generation { 0 };
+  std::string query;
+  std::string matched_query;
+  match_set matched;
+  size_t num_matches;
+  std::chrono::steady_clock::time_point started;
+  std::chrono::nanoseconds latency { 0 };
+  bool matching { false };
+
+  // Replacing it stops the running query and waits for it
+  std::jthread matcher;
+
+  // Declared last so it is destroyed first, and filter() never runs on a half destroyed picker
+  entry_watch input;
+
+  static bool is_word_start(const std::string_view TEXT, const size_t AT)
+  {
+    if (AT == 0) {
+      return true;
+    }
+
+    const char PREVIOUS { TEXT[AT - 1] };
+    return PREVIOUS == '/' or PREVIOUS == '_' or PREVIOUS == '-' or PREVIOUS == '.' or PREVIOUS == ' ' or (PREVIOUS >= 'a' and PREVIOUS <= 'z' and TEXT[AT] >= 'A' and TEXT[AT] <= 'Z');
+  }
+
+  /*
+   * The query characters must appear in order in SEARCHED, consecutive characters and
+   * characters starting a word of CANDIDATE score more, skipped characters less.
+   * Returns -1 when not matching
+   */
+  static int score(const std::string_view CANDIDATE, const std::string_view SEARCHED, const std::string_view QUERY)
   {
-    newtTextboxSetText(*data, TEXT.data());
+    int total { 0 };
+    size_t at { 0 };
+    size_t previous { std::string_view::npos };
+
+    for (const char WANTED : QUERY) {
+      const void* const FOUND { (at < SEARCHED.size()) ? std::memchr(SEARCHED.data() + at, WANTED, SEARCHED.size() - at) : nullptr };
+      if (FOUND == nullptr) {
+        return -1;
+      }
+      at = static_cast<size_t>(static_cast<const char*>(FOUND) - SEARCHED.data());
+
+      total += 16;
+      if (previous != std::string_view::npos and at == previous + 1) {
+        total += 12;
+      } else if (previous != std::string_view::npos) {
+        total -= static_cast<int>(std::min<size_t>(at - previous - 1, 8));
+      }
+      if (is_word_start(CANDIDATE, at)) {
+        total += 8;
+      }
+
+      previous = at++;
+    }
+
+    return total;
   }
 
-  void set_text(const std::string_view TEXT)
+  static bool better(const match& LEFT, const match& RIGHT)
   {
-    newtTextboxSetText(*data, TEXT.data());
+    return std::tuple { -LEFT.score, LEFT.length, LEFT.index } < std::tuple { -RIGHT.score, RIGHT.length, RIGHT.index };
   }
 
-  void set_height(const int HEIGHT)
+  // Keeps the best LIMIT matches, sorted
+  void keep_best(std::vector<match>& MATCHES) const
   {
-    newtTextboxSetHeight(*data, HEIGHT);
+    if (MATCHES.size() > limit) {
+      std::nth_element(MATCHES.begin(), MATCHES.begin() + static_cast<std::ptrdiff_t>(limit), MATCHES.end(), better);
+      MATCHES.resize(limit);
+    }
+    std::sort(MATCHES.begin(), MATCHES.end(), better);
   }
 
-  [[nodiscard]] int get_num_lines() const
+  // Runs on the matcher thread, returns early once STOP is requested
+  void run_query(const std::stop_token& STOP, const std::uint64_t GENERATION, const std::string& QUERY, const match_set& SCOPE)
   {
-    return newtTextboxGetNumLines(*data);
+    const bool IGNORE_CASE { std::ranges::none_of(QUERY, [](const char CHAR) { return CHAR >= 'A' and CHAR <= 'Z'; }) };
+    const std::string& SEARCHED { IGNORE_CASE ? folded : text };
+    const size_t SIZE { SCOPE ? SCOPE->size() : num_candidates() };
+
+    constexpr size_t MIN_CHUNK { 1U << 14U };
+    const size_t CHUNKS { std::clamp<size_t>(SIZE / MIN_CHUNK, 1, std::max(std::thread::hardware_concurrency(), 1U)) };
+
+    struct chunk_result {
+      std::vector<std::uint32_t> matched;
+      std::vector<match> best;
+    };
+    std::vector<chunk_result> results(CHUNKS);
+
+    const auto MATCH_CHUNK { [&](const size_t CHUNK) {
+      auto& [MATCHED, BEST] = results[CHUNK];
+      const size_t END { SIZE * (CHUNK + 1) / CHUNKS };
+      for (size_t position { SIZE * CHUNK / CHUNKS }; position < END; ++position) {
+        if ((position % 1024) == 0 and STOP.stop_requested()) {
+          return;
+        }
+
+        const auto INDEX { SCOPE ? (*SCOPE)[position] : static_cast<std::uint32_t>(position) };
+        const auto CANDIDATE { candidate(text, INDEX) };
+        const int SCORE { score(CANDIDATE, candidate(SEARCHED, INDEX), QUERY) };
+        if (SCORE < 0) {
+          continue;
+        }
+
+        // BEST is a heap with the worst of the best matches on top
+        MATCHED.push_back(INDEX);
+        const match FOUND { SCORE, static_cast<std::uint32_t>(CANDIDATE.size()), INDEX };
+        if (BEST.size() < limit) {
+          BEST.push_back(FOUND);
+          std::ranges::push_heap(BEST, better);
+        } else if (limit != 0 and better(FOUND, BEST.front())) {
+          std::ranges::pop_heap(BEST, better);
+          BEST.back() = FOUND;
+          std::ranges::push_heap(BEST, better);
+        }
+      }
+    } };
+
+    {
+      std::vector<std::jthread> workers;
+      for (size_t chunk { 1 }; chunk < CHUNKS; ++chunk) {
+        workers.emplace_back(MATCH_CHUNK, chunk);
+      }
+      MATCH_CHUNK(0);
+    }
+
+    if (STOP.stop_requested()) {
+      return;
+    }
+
+    // Chunks are consecutive, so the matched candidates stay in candidate order
+    auto all_matched { std::make_shared<std::vector<std::uint32_t>>() };
+    std::vector<match> best;
+    all_matched->reserve(std::accumulate(results.begin(), results.end(), size_t { 0 }, [](const size_t TOTAL, const chunk_result& RESULT) { return TOTAL + RESULT.matched.size(); }));
+    for (auto& [MATCHED, BEST] : results) {
+      all_matched->insert(all_matched->end(), MATCHED.begin(), MATCHED.end());
+      best.insert(best.end(), BEST.begin(), BEST.end());
+    }
+    keep_best(best);
+
+    completions.post([this, GENERATION, QUERY, MATCHED = match_set { std::move(all_matched) }, BEST = std::move(best)]() mutable {
+      if (GENERATION != generation) {
+        return;
+      }
+
+      std::vector<std::uint32_t> shown(BEST.size());
+      std::ranges::transform(BEST, shown.begin(), &match::index);
+      publish(std::move(shown), MATCHED->size());
+      matched_query = std::move(QUERY);
+      matched = std::move(MATCHED);
+    });
   }
 
-  // NOLINTNEXTLINE -- still the best way
-  void set_colors(const int NORMAL, const int ACTIVE)
+  void publish(std::vector<std::uint32_t> SHOWN, const size_t NUM_MATCHES)
   {
-    newtTextboxSetColors(*data, NORMAL, ACTIVE);
+    top = std::move(SHOWN);
+    num_matches = NUM_MATCHES;
+    latency = std::chrono::steady_clock::now() - started;
+    matching = false;
+    set_current(0);
   }
-};
 
-class textbox_reflowed : public component {
-  std::string text;
-  static const int FLEX_DEVIDER { 5 };
+  void filter(const std::string_view QUERY)
+  {
+    if (QUERY == query) {
+      return;
+    }
+
+    query = QUERY;
+    const auto GENERATION { ++generation };
+    started = std::chrono::steady_clock::now();
+
+    if (query.empty()) {
+      matcher = {};
+      matched_query.clear();
+      matched.reset();
+
+      std::vector<std::uint32_t> shown(std::min(limit, num_candidates()));
+      std::iota(shown.begin(), shown.end(), std::uint32_t { 0 });
+      publish(std::move(shown), num_candidates());
+      return;
+    }
+
+    // A query extending the last one can only match what that one matched
+    match_set scope { query.starts_with(matched_query) ? matched : nullptr };
+
+    matching = true;
+    matcher = std::jthread { [this, GENERATION, QUERY = query, SCOPE = std::move(scope)](const std::stop_token& STOP) {
+      run_query(STOP, GENERATION, QUERY, SCOPE);
+    } };
+  }
 
   public:
-  void set_text(const std::string_view TEXT)
+  // Shows the best TOP CANDIDATES matching the text of INPUT, in a list HEIGHT rows tall
+  template <std::ranges::input_range range>
+    requires std::convertible_to<std::ranges::range_reference_t<range>, std::string_view>
+  fuzzy_picker(entrybox& INPUT, const int HEIGHT, range&& CANDIDATES, const position POS = { 0, 0 }, const size_t TOP = 1000)
+      : fuzzy_results(std::forward<range>(CANDIDATES))
+      , listbox(HEIGHT, *this, POS)
+      , limit(TOP)
+      , num_matches(num_candidates())
+      , input(INPUT, [this](const std::string_view QUERY) { filter(QUERY); })
   {
-    text = TEXT;
-    newtTextboxSetText(*data, text.data());
+    top.resize(std::min(limit, num_candidates()));
+    std::iota(top.begin(), top.end(), std::uint32_t { 0 });
+    reload();
   }
 
-  explicit textbox_reflowed(const int WIDTH, const std::string_view TEXT, const position POS = { 0, 0 }) noexcept
-      : component(newtTextboxReflowed(POS.left, POS.top, const_cast<char*>(TEXT.data()), WIDTH, static_cast<int>(WIDTH / FLEX_DEVIDER), static_cast<int>(WIDTH / FLEX_DEVIDER), 0)) // NOLINT -- newt takes char* instead of cosnt char*
+  fuzzy_picker(const fuzzy_picker&) = delete;
+  fuzzy_picker(fuzzy_picker&&) = delete;
+  fuzzy_picker& operator=(const fuzzy_picker&) = delete;
+  fuzzy_picker& operator=(fuzzy_picker&&) = delete;
+
+  ~fuzzy_picker() = default;
+
+  // Results are shown on the thread running FORM
+  void attach(form& FORM)
   {
-    set_text(TEXT);
+    completions.attach(FORM);
   }
 
-  void set_height(const int HEIGHT)
+  // Filters again for the current value of the entry, for text changed by set_value()
+  void update()
   {
-    newtTextboxSetHeight(*data, HEIGHT);
+    input.notify();
   }
 
-  [[nodiscard]] int get_num_lines() const
+  // Index in the candidates of the selected row, npos when nothing matches
+  [[nodiscard]] size_t get_selected() const
   {
-    return newtTextboxGetNumLines(*data);
+    return top.empty() ? std::string_view::npos : top[get_current()];
   }
 
-  // NOLINTNEXTLINE -- still the best way
-  void set_colors(const int NORMAL, const int ACTIVE)
+  [[nodiscard]] std::string_view get_candidate(const size_t INDEX) const
+  {
+    return candidate(text, INDEX);
+  }
+
+  [[nodiscard]] size_t get_num_candidates() const
+  {
+    return num_candidates();
+  }
+
+  // Matches of the last shown query, not only the ones shown
+  [[nodiscard]] size_t get_num_matches() const
+  {
+    return num_matches;
+  }
+
+  [[nodiscard]] bool is_matching() const
+  {
+    return matching;
+  }
+
+  // Time from the key press to the results of the last shown query
+  [[nodiscard]] std::chrono::nanoseconds get_latency() const
   {
-    newtTextboxSetColors(*data, NORMAL, ACTIVE);
+    return latency;
   }
 };
 